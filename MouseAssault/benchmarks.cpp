@@ -0,0 +1,695 @@
+#include "benchmarks.h"
+#include "gamedata.h"
+#include "collision.h"
+#include "snapshothistory.h"
+#include "jitterprofiler.h"
+#include "pipeline.h"
+#include "ringintegrator.h"
+#include "binaryangle.h"
+#include "offscreenrenderer.h"
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QVector>
+#include <random>
+#include <iostream>
+
+using namespace GameEnvironment;
+
+int Benchmarks::run(const QStringList & arguments)
+{
+	int bench = arguments.indexOf("--bench");
+	QString name = bench >= 0 && bench + 1 < arguments.count() ? arguments[bench + 1] : QString();
+
+	if (name == "static-level")
+		return staticLevel();
+	if (name == "restart")
+		return restart();
+	if (name == "rewind")
+		return rewind();
+	if (name == "cursor")
+		return cursor();
+	if (name == "jitter")
+		return jitter(arguments);
+	if (name == "integrate")
+		return integrate(arguments);
+	if (name == "angles")
+		return angles();
+	if (name == "tiled")
+		return tiled(arguments);
+
+	std::cerr << "usage: MouseAssault --bench static-level|restart|rewind|cursor|jitter|integrate|angles|tiled" << std::endl;
+	return 1;
+}
+
+int Benchmarks::staticLevel()
+{
+	const int ticks = 200000;
+	const int stepsCount = 4096;
+
+	//random cursors over the whole test level, every other one as the arrow polygon, with dragging and freezing
+	QVector<Ring> rings = testLevel().rings;
+	int radius = testLevelTable.totalRadius();
+	std::mt19937 random(7);
+	std::uniform_real_distribution<double> unit(0, 1);
+	CursorShape arrow = CursorShape::arrow();
+	QVector<CursorPolygon> polygons(stepsCount);
+	QVector<RingStep> steps(stepsCount);
+	for (int i = 0; i < stepsCount; i++)
+	{
+		double distance = unit(random) * radius;
+		double angle = unit(random) * 2 * M_PI;
+		QRectF rect(distance * cos(angle), distance * sin(angle), 10, 18);
+		arrow.place(rect, polygons[i]);
+		steps[i] = { 0, (unit(random) - 0.5) * 0.2, 1.5, unit(random) < 0.3, unit(random) < 0.1, false, rect, i % 2 ? &polygons[i] : nullptr };
+	}
+
+	RingIntegrator dynamicIntegrator;
+	RingIntegrator staticIntegrator;
+	dynamicIntegrator.setThreadCount(1);
+	staticIntegrator.setThreadCount(1);
+	staticIntegrator.setStaticIntegration(new StaticLevelIntegration<7, 6>(testLevelTable));
+
+	auto play = [&](RingIntegrator &integrator, QVector<int> &finishers, QVector<double> &horizons, QVector<Ring> &last) {
+		QVector<Ring> source = rings;
+		QVector<Ring> target;
+		QElapsedTimer timer;
+		timer.start();
+		for (int i = 0; i < ticks; i++)
+		{
+			RingStep step = steps[i % stepsCount];
+			step.deltaTime = i * 5.0;
+			double horizon = INFINITY;
+			finishers[i] = integrator.integrate(source, target, step, horizon);
+			horizons[i] = horizon;
+			source.swap(target);
+		}
+		last = source;
+		return timer.nsecsElapsed();
+	};
+
+	QVector<int> dynamicFinishers(ticks);
+	QVector<int> staticFinishers(ticks);
+	QVector<double> dynamicHorizons(ticks);
+	QVector<double> staticHorizons(ticks);
+	QVector<Ring> dynamicRings;
+	QVector<Ring> staticRings;
+	qint64 dynamicTime = play(dynamicIntegrator, dynamicFinishers, dynamicHorizons, dynamicRings);
+	qint64 staticTime = play(staticIntegrator, staticFinishers, staticHorizons, staticRings);
+
+	int mismatches = 0;
+	for (int i = 0; i < ticks; i++)
+		mismatches += dynamicFinishers[i] != staticFinishers[i] || dynamicHorizons[i] != staticHorizons[i];
+	for (int i = 0; i < rings.count(); i++)
+	{
+		const Ring &a = dynamicRings[i];
+		const Ring &b = staticRings[i];
+		mismatches += a.rotation != b.rotation || a.additionalRotation != b.additionalRotation || a.selectedScore != b.selectedScore
+			|| a.isSelected != b.isSelected || a.isRotating != b.isRotating;
+	}
+
+	std::cout << "dynamic rings: " << double(dynamicTime) / ticks << " ns/tick" << std::endl;
+	std::cout << "static rings:  " << double(staticTime) / ticks << " ns/tick" << std::endl;
+	std::cout << "speedup: " << double(dynamicTime) / qMax<qint64>(staticTime, 1) << "x, mismatches: " << mismatches << std::endl;
+	return mismatches == 0 ? 0 : 1;
+}
+
+int Benchmarks::restart()
+{
+	const int restarts = 200;
+
+	Game game(testLevel());
+	QMutex startMutex;
+	QWaitCondition started;
+	int startCount = 0;
+	QObject::connect(&game, &Game::Start, &game, [&]() {
+		QMutexLocker locker(&startMutex);
+		startCount++;
+		started.wakeAll();
+	}, Qt::DirectConnection);
+
+	auto waitForStart = [&](int count) {
+		QMutexLocker locker(&startMutex);
+		while (startCount < count)
+			started.wait(&startMutex);
+	};
+
+	QElapsedTimer timer;
+	timer.start();
+	for (int i = 0; i < restarts; i++)
+	{
+		game.stopExecution();
+		game.wait();
+		game.startExecution();
+		waitForStart(i + 1);
+	}
+	qint64 threadTime = timer.nsecsElapsed();
+
+	timer.restart();
+	for (int i = 0; i < restarts; i++)
+	{
+		game.restart();
+		waitForStart(restarts + i + 1);
+	}
+	qint64 restartTime = timer.nsecsElapsed();
+
+	game.stopExecution();
+	game.wait();
+
+	timer.restart();
+	for (int i = 0; i < restarts; i++)
+		game.reset();
+	qint64 resetTime = timer.nsecsElapsed();
+
+	std::cout << "new thread:    " << double(threadTime) / restarts / 1000 << " us/restart" << std::endl;
+	std::cout << "same thread:   " << double(restartTime) / restarts / 1000 << " us/restart" << std::endl;
+	std::cout << "reset only:    " << double(resetTime) / restarts / 1000 << " us/reset" << std::endl;
+	return 0;
+}
+
+int Benchmarks::rewind()
+{
+	const int restores = 100000;
+
+	//a replayed game feeds the history the way a real one does
+	Game game(testLevel());
+	SnapshotHistory history;
+	game.reset();
+	game.setMouseRect(QRectF(-200, -200, 10, 18));
+	game.startRingDragging();
+	for (int time = 0; time <= 10000; time += 50)
+	{
+		game.setMouseRect(QRectF(200 * cos(time / 700.0), 200 * sin(time / 700.0), 10, 18));
+		game.tick(time);
+		FrameState frame = game.frameState();
+		SimulationState state;
+		state.currentCoreWidthScore = frame.coreWidthScore;
+		state.currentEnergyVolume = frame.energyVolume;
+		state.currentFreezeVolume = frame.freezeVolume;
+		history.push(time, state, frame.rings);
+	}
+
+	QVector<Ring> rings = game.frameState().rings;
+	SimulationState state;
+	int fullSize = int(sizeof(SimulationState) + rings.count() * sizeof(Ring)) * history.count();
+	std::cout << "snapshots: " << history.count() << ", " << history.memoryUsage() << " bytes delta encoded, "
+		<< fullSize << " bytes as full copies" << std::endl;
+
+	//restoring a snapshot drops the newer ones, restoring it again costs the same
+	const int depths[] = { 1, history.count() / 2, history.count() - 1 };
+	for (int depth : depths)
+	{
+		SnapshotHistory rewound = history;
+		int index = rewound.count() - 1 - depth;
+
+		QElapsedTimer timer;
+		timer.start();
+		for (int i = 0; i < restores; i++)
+			rewound.restore(index, state, rings);
+		qint64 restoreTime = timer.nsecsElapsed();
+
+		std::cout << "rewind " << depth << " snapshots: " << double(restoreTime) / restores << " ns" << std::endl;
+	}
+
+	//the tick flattens and diffs the whole level every snapshot interval, and large levels index past 16 bits
+	const int ringCounts[] = { 100, 2000, 10000 };
+	int corrupted = 0;
+	for (int ringCount : ringCounts)
+	{
+		QVector<Ring> levelRings = stressLevel(ringCount, 5).rings;
+		SnapshotHistory large;
+		SimulationState largeState;
+		QElapsedTimer timer;
+		qint64 pushTime = 0;
+		int pushes = 0;
+		for (int time = 0; time <= 5000; time += 50)
+		{
+			for (int i = pushes % 3; i < levelRings.count(); i += 3)
+				levelRings[i].rotation += 0.01;
+			timer.start();
+			large.push(time, largeState, levelRings);
+			pushTime += timer.nsecsElapsed();
+			pushes++;
+		}
+
+		//the newest snapshot is a delta, it has to come back as it was pushed
+		QVector<Ring> restored = levelRings;
+		for (Ring &ring : restored)
+			ring.rotation = -1;
+		large.restore(large.count() - 1, largeState, restored);
+		int wrong = 0;
+		for (int i = 0; i < restored.count(); i++)
+			wrong += restored[i].rotation != levelRings[i].rotation;
+		corrupted += wrong;
+
+		std::cout << ringCount << " rings: push " << double(pushTime) / pushes / 1000 << " us, "
+			<< large.memoryUsage() << " bytes, " << wrong << " rings restored wrong" << std::endl;
+	}
+	return corrupted == 0 ? 0 : 1;
+}
+
+int Benchmarks::cursor()
+{
+	const int queries = 1000000;
+	const int rectsCount = 4096;
+	const int sampledQueries = 20000;
+	const int samples = 40;//per axis
+
+	std::mt19937 random(11);
+	std::uniform_real_distribution<double> position(-300, 300);
+	QVector<QRectF> rects;
+	for (int i = 0; i < rectsCount; i++)
+		rects.append(QRectF(position(random), position(random), 10, 18));
+
+	CursorShape rectShape({ { 0, 0 }, { 10, 0 }, { 10, 18 }, { 0, 18 } });
+	CursorShape arrowShape = CursorShape::arrow();
+	QVector<CursorPolygon> rectPolygons(rectsCount);
+	QVector<CursorPolygon> arrowPolygons(rectsCount);
+	for (int i = 0; i < rectsCount; i++)
+	{
+		rectShape.place(rects[i], rectPolygons[i]);
+		arrowShape.place(rects[i], arrowPolygons[i]);
+	}
+
+	QVector<Ring> rings = testLevelTable.toRings();
+	QVector<QPointF> points;
+	QVector<double> angles;
+	QVector<char> rectOutcomes(queries);
+	QVector<char> rectPolygonOutcomes(queries);
+	QVector<char> arrowOutcomes(queries);
+	auto rotate = [&rings](int i) {
+		for (int j = 1; j < rings.count(); j++)
+			rings[j].rotation = Circle::adjustAngle(rings[j].angleSpeed * i / double(1000));
+	};
+
+	QElapsedTimer timer;
+	timer.start();
+	for (int i = 0; i < queries; i++)
+	{
+		rotate(i);
+		rectOutcomes[i] = Collision::test(rings, rects[i % rectsCount], points);
+	}
+	qint64 rectTime = timer.nsecsElapsed();
+
+	timer.restart();
+	for (int i = 0; i < queries; i++)
+	{
+		rotate(i);
+		rectPolygonOutcomes[i] = Collision::test(rings, rectPolygons[i % rectsCount], points, angles);
+	}
+	qint64 rectPolygonTime = timer.nsecsElapsed();
+
+	timer.restart();
+	for (int i = 0; i < queries; i++)
+	{
+		rotate(i);
+		arrowOutcomes[i] = Collision::test(rings, arrowPolygons[i % rectsCount], points, angles);
+	}
+	qint64 arrowTime = timer.nsecsElapsed();
+
+	int narrowArcHits = 0;
+	int avoidedLosses = 0;
+	for (int i = 0; i < queries; i++)
+	{
+		narrowArcHits += rectOutcomes[i] != Collision::Lost && rectPolygonOutcomes[i] == Collision::Lost;
+		avoidedLosses += rectOutcomes[i] == Collision::Lost && arrowOutcomes[i] == Collision::None;
+	}
+
+	//a dense grid inside the arrow must never find a hit the exact test missed
+	int missed = 0;
+	for (int i = 0; i < sampledQueries; i++)
+	{
+		rotate(i);
+		const CursorPolygon &polygon = arrowPolygons[i % rectsCount];
+		const QRectF &rect = rects[i % rectsCount];
+		Collision::Outcome sampled = Collision::None;
+		for (int r = 0; r < rings.count() && sampled == Collision::None; r++)
+		{
+			const Ring &ring = rings[r];
+			double fullRotation = ring.additionalRotation + ring.rotation;
+			for (int sx = 0; sx <= samples && sampled == Collision::None; sx++)
+			{
+				for (int sy = 0; sy <= samples && sampled == Collision::None; sy++)
+				{
+					QPointF point(rect.x() + rect.width() * sx / samples, rect.y() + rect.height() * sy / samples);
+					bool inside = true;
+					for (int e = 0; e < polygon.normals.count(); e++)
+						inside = inside && QPointF::dotProduct(polygon.normals[e], point) <= polygon.offsets[e];
+					double sqrRadius = QPointF::dotProduct(point, point);
+					if (!inside || sqrRadius < pow(ring.internalRadius, 2.0) || sqrRadius > pow(ring.internalRadius + ring.width, 2.0))
+						continue;
+					if (r == 0)
+						sampled = Collision::Won;
+					for (int a = 0; a < ring.arcs.count() && sampled == Collision::None; a++)
+					{
+						if (Collision::arcHit(QVector<QPointF>{ point }, fullRotation, ring.arcs[a]))
+							sampled = Collision::Lost;
+					}
+				}
+			}
+		}
+		missed += sampled == Collision::Won ? arrowOutcomes[i] != Collision::Won : sampled == Collision::Lost && arrowOutcomes[i] == Collision::None;
+	}
+
+	std::cout << "rect:          " << double(rectTime) / queries << " ns/query" << std::endl;
+	std::cout << "rect polygon:  " << double(rectPolygonTime) / queries << " ns/query, " << narrowArcHits << " hits on arcs narrower than the rect" << std::endl;
+	std::cout << "arrow polygon: " << double(arrowTime) / queries << " ns/query, " << avoidedLosses << " rect losses avoided" << std::endl;
+	std::cout << "sampled " << sampledQueries << " arrow queries, missed hits: " << missed << std::endl;
+	return missed == 0 ? 0 : 1;
+}
+
+int Benchmarks::jitter(const QStringList & arguments)
+{
+	//--load <threads> --period <ms> --seconds <s> and the scheduling options of the game
+	auto value = [&arguments](const char *option, int fallback) {
+		int index = arguments.indexOf(option);
+		return index >= 0 && index + 1 < arguments.count() ? arguments[index + 1].toInt() : fallback;
+	};
+	int loadThreads = value("--load", QThread::idealThreadCount());
+	int period = qMax(1, value("--period", 2));
+	int seconds = qMax(1, value("--seconds", 5));
+	SchedulingOptions options = SchedulingOptions::fromArguments(arguments);
+
+	QAtomicInt stop;
+	QVector<PipelineStage*> load;
+	for (int i = 0; i < loadThreads; i++)
+	{
+		load.append(new PipelineStage([&stop]()
+		{
+			volatile double sink = 0;
+			while (!stop.loadAcquire())
+			{
+				for (int j = 1; j < 10000; j++)
+					sink = sink + sqrt(double(j));
+			}
+		}));
+		load.last()->start();
+	}
+
+	//the same timed wait the simulation sleeps in between events
+	JitterProfiler profiler;
+	PipelineStage ticker([&]()
+	{
+		options.apply();
+		QMutex mutex;
+		QWaitCondition never;
+		QElapsedTimer clock;
+		clock.start();
+		QMutexLocker locker(&mutex);
+		for (qint64 next = period; next <= seconds * 1000; next += period)
+		{
+			double wait = next - clock.nsecsElapsed() / 1e6;
+			if (wait > 0)
+				never.wait(&mutex, ulong(ceil(wait)));
+			profiler.record(clock.nsecsElapsed() / 1e6 - next);
+		}
+	});
+	ticker.start();
+	ticker.wait();
+
+	stop.storeRelease(1);
+	for (int i = 0; i < load.count(); i++)
+		load[i]->wait();
+	qDeleteAll(load);
+
+	std::cout << loadThreads << " load threads, " << period << " ms period" << std::endl;
+	profiler.report(std::cout);
+	return 0;
+}
+
+int Benchmarks::integrate(const QStringList & arguments)
+{
+	//--rings <count> --ticks <count> --threads <count>
+	auto value = [&arguments](const char *option, int fallback) {
+		int index = arguments.indexOf(option);
+		return index >= 0 && index + 1 < arguments.count() ? arguments[index + 1].toInt() : fallback;
+	};
+	int ringCount = qMax(1, value("--rings", 10000));
+	int ticks = qMax(1, value("--ticks", 2000));
+	int threads = qMax(2, value("--threads", QThread::idealThreadCount()));
+
+	GameSettings level = stressLevel(ringCount, 5);
+	Game serial(level);
+	Game parallel(level);
+	serial.setParallelIntegration(1, 0);
+	parallel.setParallelIntegration(threads, 0);
+
+	//the cursor spirals out through the rings with the button held, so rings get selected, dragged and hit
+	QElapsedTimer timer;
+	qint64 serialTime = 0;
+	qint64 parallelTime = 0;
+	int mismatches = 0;
+	Game *games[] = { &serial, &parallel };
+	for (Game *game : games)
+	{
+		game->reset();
+		game->startRingDragging();
+	}
+	for (int i = 0; i < ticks; i++)
+	{
+		double radius = 40 + double(i) / ticks * ringCount;
+		QRectF rect(radius * cos(i / 50.0), radius * sin(i / 50.0), 10, 18);
+		for (Game *game : games)
+			game->setMouseRect(rect);
+
+		timer.restart();
+		serial.tick(i * 5);
+		serialTime += timer.nsecsElapsed();
+		timer.restart();
+		parallel.tick(i * 5);
+		parallelTime += timer.nsecsElapsed();
+
+		FrameState a = serial.frameState();
+		FrameState b = parallel.frameState();
+		bool same = a.coreWidthScore == b.coreWidthScore && a.gameWon == b.gameWon && a.rings.count() == b.rings.count();
+		for (int j = 0; same && j < a.rings.count(); j++)
+		{
+			same = a.rings[j].rotation == b.rings[j].rotation && a.rings[j].additionalRotation == b.rings[j].additionalRotation
+				&& a.rings[j].selectedScore == b.rings[j].selectedScore && a.rings[j].isSelected == b.rings[j].isSelected
+				&& a.rings[j].isRotating == b.rings[j].isRotating;
+		}
+		mismatches += !same;
+	}
+
+	std::cout << ringCount << " rings, " << threads << " threads" << std::endl;
+	std::cout << "serial tick:   " << double(serialTime) / ticks / 1000 << " us" << std::endl;
+	std::cout << "parallel tick: " << double(parallelTime) / ticks / 1000 << " us" << std::endl;
+	std::cout << "mismatching ticks: " << mismatches << std::endl;
+	return mismatches == 0 ? 0 : 1;
+}
+
+int Benchmarks::angles()
+{
+	const int tests = 20000000;
+	const int inputsCount = 4096;
+	const int ticks = 20000;
+	const double quantum = 1e-8;//radians, far above the 1.5e-9 step of a binary angle
+
+	//single interval tests, a point that close to an arc end may land on either side of it
+	std::mt19937 random(13);
+	std::uniform_real_distribution<double> unit(0, 1);
+	QVector<double> pointAngles(inputsCount);
+	QVector<double> rotations(inputsCount);
+	QVector<Arc> arcs(inputsCount);
+	QVector<BinaryAngle> binaryPoints(inputsCount);
+	QVector<BinaryAngle> binaryRotations(inputsCount);
+	QVector<BinaryArc> binaryArcs(inputsCount);
+	for (int i = 0; i < inputsCount; i++)
+	{
+		pointAngles[i] = Game::atan4(unit(random) - 0.5, unit(random) - 0.5);
+		rotations[i] = (unit(random) - 0.5) * 8 * M_PI;
+		arcs[i] = { unit(random), unit(random) * 0.9 };
+		binaryPoints[i] = BinaryAngles::fromRadians(pointAngles[i]);
+		binaryRotations[i] = BinaryAngles::fromRadians(rotations[i]);
+		binaryArcs[i] = BinaryAngles::fromArc(arcs[i]);
+	}
+
+	QVector<char> doubleHits(inputsCount);
+	QVector<char> binaryHits(inputsCount);
+	volatile int sink = 0;
+	QElapsedTimer timer;
+	timer.start();
+	for (int i = 0; i < tests; i++)
+	{
+		int k = i % inputsCount;
+		int a = (i / inputsCount + k) % inputsCount;
+		double startAngle;
+		double endAngle;
+		Collision::arcAngles(rotations[a], arcs[a].position * 2.0 * M_PI, (arcs[a].position + arcs[a].length) * 2.0 * M_PI, startAngle, endAngle);
+		sink = sink + Collision::angleInArc(pointAngles[k], startAngle, endAngle);
+	}
+	qint64 doubleTime = timer.nsecsElapsed();
+
+	timer.restart();
+	for (int i = 0; i < tests; i++)
+	{
+		int k = i % inputsCount;
+		int a = (i / inputsCount + k) % inputsCount;
+		sink = sink + BinaryAngles::inArc(binaryPoints[k], binaryRotations[a] + binaryArcs[a].start, binaryArcs[a].length);
+	}
+	qint64 binaryTime = timer.nsecsElapsed();
+
+	int mismatches = 0;
+	int edgeMismatches = 0;
+	for (int k = 0; k < inputsCount; k++)
+	{
+		for (int a = 0; a < inputsCount; a += 7)
+		{
+			double startAngle;
+			double endAngle;
+			Collision::arcAngles(rotations[a], arcs[a].position * 2.0 * M_PI, (arcs[a].position + arcs[a].length) * 2.0 * M_PI, startAngle, endAngle);
+			bool doubleHit = Collision::angleInArc(pointAngles[k], startAngle, endAngle);
+			bool binaryHit = BinaryAngles::inArc(binaryPoints[k], binaryRotations[a] + binaryArcs[a].start, binaryArcs[a].length);
+			if (doubleHit == binaryHit)
+				continue;
+			double distance = qMin(qAbs(remainder(pointAngles[k] - startAngle, 2 * M_PI)), qAbs(remainder(pointAngles[k] - endAngle, 2 * M_PI)));
+			if (distance < quantum)
+				edgeMismatches++;
+			else
+				mismatches++;
+		}
+	}
+
+	std::cout << "double interval test: " << double(doubleTime) / tests << " ns" << std::endl;
+	std::cout << "binary interval test: " << double(binaryTime) / tests << " ns" << std::endl;
+	std::cout << "mismatches: " << mismatches << ", within " << quantum << " rad of an arc end: " << edgeMismatches << std::endl;
+
+	//degenerate arcs: an empty arc hits nothing, a full turn is clamped and hits everything but its ends
+	int degenerateFailures = 0;
+	degenerateFailures += BinaryAngles::fromArc({ 0.25, 0 }).length != 0;
+	degenerateFailures += BinaryAngles::fromArc({ 0.25, -0.5 }).length != 0;
+	degenerateFailures += BinaryAngles::fromArc({ 0.25, 1 }).length != BinaryAngles::maxLength;
+	degenerateFailures += BinaryAngles::fromArc({ 0.25, 1.5 }).length != BinaryAngles::maxLength;
+	for (int k = 0; k < inputsCount; k++)
+	{
+		BinaryAngle start = binaryRotations[k];
+		degenerateFailures += BinaryAngles::inArc(binaryPoints[k], start, 0);
+		degenerateFailures += BinaryAngles::inArc(binaryPoints[k], start, BinaryAngles::fromArc({ 0, 1 }).length) != (binaryPoints[k] != start && binaryPoints[k] != BinaryAngle(start - 1));
+	}
+	degenerateFailures += BinaryAngles::inArc(5, 5, BinaryAngles::maxLength);
+	degenerateFailures += !BinaryAngles::inArc(6, 5, BinaryAngles::maxLength);
+	degenerateFailures += BinaryAngles::inArc(5, 5, 0) || BinaryAngles::inArc(6, 5, 0);
+	std::cout << "failed zero length and full turn cases: " << degenerateFailures << std::endl;
+
+	//whole ticks of a stress level through both ring integrators, the outcome of every tick is compared
+	GameSettings level = stressLevel(2000, 9);
+	QVector<Ring> rings;
+	int radius = 0;
+	for (Ring ring : level.rings)
+	{
+		ring.internalRadius = radius;
+		radius += ring.width;
+		rings.append(ring);
+	}
+	RingIntegrator doubleIntegrator;
+	RingIntegrator binaryIntegrator;
+	doubleIntegrator.setThreadCount(1);
+	binaryIntegrator.setThreadCount(1);
+	binaryIntegrator.setBinaryArcs(rings);
+
+	QVector<Ring> doubleRings = rings;
+	QVector<Ring> binaryRings = rings;
+	QVector<Ring> target;
+	qint64 doubleTickTime = 0;
+	qint64 binaryTickTime = 0;
+	int tickMismatches = 0;
+	for (int i = 0; i < ticks; i++)
+	{
+		double distance = 40 + unit(random) * radius;
+		double angle = unit(random) * 2 * M_PI;
+		RingStep step = { i * 5.0, 0, 1.5, false, false, false, QRectF(distance * cos(angle), distance * sin(angle), 10, 18), nullptr };
+		double horizon = INFINITY;
+
+		timer.restart();
+		int doubleFinisher = doubleIntegrator.integrate(doubleRings, target, step, horizon);
+		doubleTickTime += timer.nsecsElapsed();
+		doubleRings.swap(target);
+
+		timer.restart();
+		int binaryFinisher = binaryIntegrator.integrate(binaryRings, target, step, horizon);
+		binaryTickTime += timer.nsecsElapsed();
+		binaryRings.swap(target);
+
+		tickMismatches += doubleFinisher != binaryFinisher;
+	}
+
+	std::cout << "double tick: " << double(doubleTickTime) / ticks / 1000 << " us" << std::endl;
+	std::cout << "binary tick: " << double(binaryTickTime) / ticks / 1000 << " us" << std::endl;
+	std::cout << "ticks with another outcome: " << tickMismatches << " of " << ticks << std::endl;
+	return mismatches == 0 && tickMismatches == 0 && degenerateFailures == 0 ? 0 : 1;
+}
+
+int Benchmarks::tiled(const QStringList & arguments)
+{
+	//--frames <count> --tolerance <channel difference> --mismatch <percent of pixels> --width <px> --height <px>
+	auto value = [&arguments](const char *option, int fallback) {
+		int index = arguments.indexOf(option);
+		return index >= 0 && index + 1 < arguments.count() ? arguments[index + 1].toInt() : fallback;
+	};
+	int framesCount = qMax(1, value("--frames", 20));
+	int tolerance = qMax(0, value("--tolerance", 24));
+	double maxMismatch = qMax(0, value("--mismatch", 1)) / 100.0;
+	QVector<QSize> sizes;//a window and a 4K screen unless a size is given
+	if (arguments.contains("--width") || arguments.contains("--height"))
+		sizes.append(QSize(qMax(1, value("--width", 800)), qMax(1, value("--height", 600))));
+	else
+		sizes << QSize(800, 600) << QSize(3840, 2160);
+
+	QVector<int> threadCounts;
+	for (int threads = 1; threads < QThread::idealThreadCount(); threads *= 2)
+		threadCounts.append(threads);
+	threadCounts.append(QThread::idealThreadCount());
+
+	//frames of a game played with the button held, so selections, rotations and the core are all drawn.
+	//Every frame is compared as soon as it is rendered, 4K references would not fit in memory together
+	Game game(testLevel());
+	game.reset();
+	game.startRingDragging();
+	OffscreenRenderer renderer(testLevel());
+	QVector<qint64> referenceTimes(sizes.count(), 0);
+	QVector<QVector<qint64>> tiledTimes(sizes.count(), QVector<qint64>(threadCounts.count(), 0));
+	double worstMismatch = 0;
+	QElapsedTimer timer;
+	for (int i = 0; i < framesCount; i++)
+	{
+		double time = i * 250.0;
+		game.setMouseRect(QRectF(150 * cos(time / 700.0), 150 * sin(time / 700.0), 10, 18));
+		game.tick(time);
+		FrameState frame = game.frameState();
+
+		for (int j = 0; j < sizes.count(); j++)
+		{
+			QImage reference(sizes[j], QImage::Format_RGB32);
+			timer.restart();
+			OffscreenRenderer::renderReference(game, reference);
+			referenceTimes[j] += timer.nsecsElapsed();
+
+			QImage image(sizes[j], QImage::Format_RGB32);
+			for (int k = 0; k < threadCounts.count(); k++)
+			{
+				renderer.setThreadCount(threadCounts[k]);
+				timer.restart();
+				renderer.render(frame, image);
+				tiledTimes[j][k] += timer.nsecsElapsed();
+				worstMismatch = qMax(worstMismatch, OffscreenRenderer::mismatchRatio(image, reference, tolerance));
+			}
+		}
+	}
+
+	for (int j = 0; j < sizes.count(); j++)
+	{
+		std::cout << framesCount << " frames of " << sizes[j].width() << "x" << sizes[j].height() << std::endl;
+		std::cout << "qpainter:          " << double(referenceTimes[j]) / framesCount / 1e6 << " ms/frame" << std::endl;
+		for (int k = 0; k < threadCounts.count(); k++)
+		{
+			int threads = threadCounts[k];
+			double speedup = double(tiledTimes[j][0]) / tiledTimes[j][k];
+			std::cout << "tiled, " << threads << (threads == 1 ? " thread:  " : " threads: ") << double(tiledTimes[j][k]) / framesCount / 1e6 << " ms/frame, "
+				<< speedup << "x of 1 thread, " << speedup / threads * 100 << "% efficiency" << std::endl;
+		}
+	}
+
+	std::cout << "worst frame: " << worstMismatch * 100 << "% of pixels differ by more than " << tolerance << std::endl;
+	return worstMismatch <= maxMismatch ? 0 : 1;
+}
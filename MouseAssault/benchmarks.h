@@ -0,0 +1,22 @@
+#pragma once
+#include <QStringList>
+
+namespace GameEnvironment
+{
+	//--bench <name> command line mode, results go to stdout
+	class Benchmarks
+	{
+	public:
+		static int run(const QStringList &arguments);
+
+	private:
+		static int staticLevel();
+		static int restart();
+		static int rewind();
+		static int cursor();
+		static int jitter(const QStringList &arguments);
+		static int integrate(const QStringList &arguments);
+		static int angles();
+		static int tiled(const QStringList &arguments);
+	};
+}
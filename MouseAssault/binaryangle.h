@@ -0,0 +1,35 @@
+#pragma once
+#include <QtGlobal>
+#include <QtMath>
+#include "gameenvironment.h"
+
+namespace GameEnvironment
+{
+	//Fixed point angle where a full turn is 2^32, so wrapping around zero is plain unsigned overflow
+	typedef quint32 BinaryAngle;
+
+	struct BinaryArc
+	{
+		BinaryAngle start;//from the ring rotation
+		BinaryAngle length;
+	};
+
+	class BinaryAngles
+	{
+	public:
+		static BinaryAngle fromRadians(double angle) { return BinaryAngle(qRound64(angle * perRadian)); }
+		static BinaryAngle fromTurns(double turns) { return BinaryAngle(qRound64(turns * fullTurn)); }
+		static double toRadians(BinaryAngle angle) { return angle / perRadian; }
+		static BinaryAngle lengthFromTurns(double turns) { return BinaryAngle(qMin<qint64>(qRound64(qBound(0.0, turns, 1.0) * fullTurn), maxLength)); }//a full turn would wrap to 0, it is clamped to maxLength instead
+		static BinaryArc fromArc(const Arc &arc) { return { fromTurns(arc.position), lengthFromTurns(arc.length) }; }
+
+		//open interval like Collision::angleInArc, arcs that wrap past zero need no branch. A length of 0 is empty
+		static bool inArc(BinaryAngle angle, BinaryAngle start, BinaryAngle length) { return length != 0 && BinaryAngle(angle - start - 1) < BinaryAngle(length - 1); }
+
+		static constexpr BinaryAngle maxLength = 0xFFFFFFFF;
+
+	private:
+		static constexpr double fullTurn = 4294967296.0;
+		static constexpr double perRadian = fullTurn / (2 * M_PI);
+	};
+}
@@ -0,0 +1,232 @@
+#include "collision.h"
+
+using namespace GameEnvironment;
+
+bool Collision::touchesRing(const QRectF & rect, double sqrInternalRadius, double sqrExternalRadius)
+{
+	double minSqr;
+	double maxSqr;
+	distanceRange(rect, minSqr, maxSqr);
+	return minSqr <= sqrExternalRadius && maxSqr >= sqrInternalRadius;
+}
+
+void Collision::distanceRange(const QRectF & rect, double & minSqr, double & maxSqr)
+{
+	double xMin = rect.x();
+	double yMin = rect.y();
+	double xMax = xMin + rect.width();
+	double yMax = yMin + rect.height();
+
+	double xMinSqr = xMin < 0 && xMax > 0 ? 0 : pow(qMin(qAbs(xMin), qAbs(xMax)), 2.0);
+	double xMaxSqr = pow(xMinSqr == 0? xMax : qMax(qAbs(xMin), qAbs(xMax)),2.0);
+	double yMinSqr = yMin < 0 && yMax > 0 ? 0 : pow(qMin(qAbs(yMin), qAbs(yMax)), 2.0);
+	double yMaxSqr = pow(yMinSqr == 0? yMax : qMax(qAbs(yMin), qAbs(yMax)), 2.0);
+
+	minSqr = xMinSqr + yMinSqr;
+	maxSqr = xMaxSqr + yMaxSqr;
+}
+
+void Collision::arcAngles(double fullRotation, double startOffset, double endOffset, double & startAngle, double & endAngle)
+{
+	startAngle = Circle::adjustAngle(fullRotation + startOffset);
+	if (startAngle < 0)
+		startAngle += 2.0 * M_PI;
+	endAngle = Circle::adjustAngle(fullRotation + endOffset);
+	if (endAngle < 0)
+		endAngle += 2.0 * M_PI;
+}
+
+bool Collision::angleInArc(double pointAngle, double startAngle, double endAngle)
+{
+	if (startAngle < endAngle)
+		return pointAngle > startAngle & pointAngle < endAngle;
+	return (pointAngle > startAngle) || (pointAngle > 0 & pointAngle < endAngle);
+}
+
+bool Collision::touchesRing(const CursorPolygon & polygon, double sqrInternalRadius, double sqrExternalRadius)
+{
+	return polygon.minSqr <= sqrExternalRadius && polygon.maxSqr >= sqrInternalRadius;
+}
+
+static double angleDifference(double a, double b)
+{
+	double difference = a - b;
+	if (difference > M_PI)
+		return difference - 2.0 * M_PI;
+	if (difference <= -M_PI)
+		return difference + 2.0 * M_PI;
+	return difference;
+}
+
+//the part of a ring covered by a cursor that misses the center spans less than half a turn,
+//its angular extremes are among the intersection points, low and high are relative to angles[0]
+static void angularSpan(const QVector<double> &angles, double &low, double &high)
+{
+	low = 0;
+	high = 0;
+	for (int k = 1; k < angles.count(); k++)
+	{
+		double difference = angleDifference(angles[k], angles[0]);
+		low = qMin(low, difference);
+		high = qMax(high, difference);
+	}
+}
+
+static bool angleInSpan(const QVector<double> &angles, double angle)
+{
+	if (angles.isEmpty())
+		return false;
+
+	double low;
+	double high;
+	angularSpan(angles, low, high);
+	double difference = angleDifference(angle, angles[0]);
+	return difference >= low && difference <= high;
+}
+
+static double positiveAngle(double angle)
+{
+	angle = fmod(angle, 2.0 * M_PI);
+	return angle < 0 ? angle + 2.0 * M_PI : angle;
+}
+
+bool Collision::radialHit(const CursorPolygon & polygon, double angle, double internalRadius, double externalRadius)
+{
+	//clips the radial segment against every edge, angles are measured with y pointing up
+	QPointF direction(cos(angle), -sin(angle));
+	double closest = internalRadius;
+	double farthest = externalRadius;
+	for (int i = 0; i < polygon.normals.count(); i++)
+	{
+		double speed = QPointF::dotProduct(polygon.normals[i], direction);
+		if (speed == 0)
+		{
+			if (polygon.offsets[i] < 0)
+				return false;
+			continue;
+		}
+
+		double t = polygon.offsets[i] / speed;
+		if (speed > 0)
+			farthest = qMin(farthest, t);
+		else
+			closest = qMax(closest, t);
+		if (closest > farthest)
+			return false;
+	}
+	return true;
+}
+
+bool Collision::sectorHit(const CursorPolygon & polygon, const QVector<double> & angles, double fullRotation, const Arc & arc, double internalRadius, double externalRadius)
+{
+	return sectorHit(polygon, angles, fullRotation, arc.position * 2.0 * M_PI, (arc.position + arc.length) * 2.0 * M_PI, internalRadius, externalRadius);
+}
+
+bool Collision::sectorHit(const CursorPolygon & polygon, const QVector<double> & angles, double fullRotation, double startOffset, double endOffset, double internalRadius, double externalRadius)
+{
+	double startAngle;
+	double endAngle;
+	arcAngles(fullRotation, startOffset, endOffset, startAngle, endAngle);
+
+	for (int k = 0; k < angles.count(); k++)
+	{
+		if (angleInArc(angles[k], startAngle, endAngle))
+			return true;
+	}
+
+	return edgeHit(polygon, angles, startAngle, endAngle, internalRadius, externalRadius);
+}
+
+bool Collision::edgeHit(const CursorPolygon & polygon, const QVector<double> & angles, double startAngle, double endAngle, double internalRadius, double externalRadius)
+{
+	//an arc edge can only pass through the polygon between the intersection points
+	bool aroundCenter = polygon.minSqr == 0;
+	if ((aroundCenter || angleInSpan(angles, startAngle)) && radialHit(polygon, startAngle, internalRadius, externalRadius))
+		return true;
+	return (aroundCenter || angleInSpan(angles, endAngle)) && radialHit(polygon, endAngle, internalRadius, externalRadius);
+}
+
+bool Collision::binaryArcHit(const QVector<BinaryAngle> & angles, BinaryAngle fullRotation, const BinaryArc & arc)
+{
+	BinaryAngle start = fullRotation + arc.start;
+	bool hit = false;
+	for (int k = 0; k < angles.count(); k++)
+		hit |= BinaryAngles::inArc(angles[k], start, arc.length);
+	return hit;
+}
+
+double Collision::contactTime(const QVector<double> & angles, double fullRotation, const Arc & arc, double angleSpeed)
+{
+	return contactTime(angles, fullRotation, arc.position * 2.0 * M_PI, (arc.position + arc.length) * 2.0 * M_PI, angleSpeed);
+}
+
+double Collision::contactTime(const QVector<double> & angles, double fullRotation, double startOffset, double endOffset, double angleSpeed)
+{
+	if (angles.isEmpty() || angleSpeed == 0)
+		return INFINITY;
+
+	double low;
+	double high;
+	angularSpan(angles, low, high);
+
+	double startAngle;
+	double endAngle;
+	arcAngles(fullRotation, startOffset, endOffset, startAngle, endAngle);
+
+	//the leading end of the arc has to turn up to the near side of the span
+	double distance = angleSpeed > 0 ? positiveAngle(angles[0] + low - endAngle) : positiveAngle(startAngle - angles[0] - high);
+	return distance / qAbs(angleSpeed);
+}
+
+Collision::Outcome Collision::test(const QVector<Ring>& rings, const CursorPolygon & polygon, QVector<QPointF>& points, QVector<double> &angles)
+{
+	for (int i = 0; i < rings.count(); i++)
+	{
+		const Ring &ring = rings[i];
+		double sqrExternalRadius = pow(ring.internalRadius + ring.width, 2.0);
+		double sqrInternalRadius = pow(ring.internalRadius, 2.0);
+
+		if (!touchesRing(polygon, sqrInternalRadius, sqrExternalRadius))
+			continue;
+		if (i == 0)
+			return Won;
+
+		points.clear();
+		intersectionPoints(polygon, sqrInternalRadius, sqrExternalRadius, points);
+		pointAngles(points, angles);
+
+		double fullRotation = ring.additionalRotation + ring.rotation;
+		for (int j = 0; j < ring.arcs.count(); j++)
+		{
+			if (sectorHit(polygon, angles, fullRotation, ring.arcs[j], ring.internalRadius, ring.internalRadius + ring.width))
+				return Lost;
+		}
+	}
+	return None;
+}
+
+Collision::Outcome Collision::test(const QVector<Ring>& rings, const QRectF & rect, QVector<QPointF>& points)
+{
+	for (int i = 0; i < rings.count(); i++)
+	{
+		const Ring &ring = rings[i];
+		double sqrExternalRadius = pow(ring.internalRadius + ring.width, 2.0);
+		double sqrInternalRadius = pow(ring.internalRadius, 2.0);
+
+		if (!touchesRing(rect, sqrInternalRadius, sqrExternalRadius))
+			continue;
+		if (i == 0)
+			return Won;
+
+		points.clear();
+		intersectionPoints(rect, sqrInternalRadius, sqrExternalRadius, points);
+
+		double fullRotation = ring.additionalRotation + ring.rotation;
+		for (int j = 0; j < ring.arcs.count(); j++)
+		{
+			if (arcHit(points, fullRotation, ring.arcs[j]))
+				return Lost;
+		}
+	}
+	return None;
+}
@@ -0,0 +1,200 @@
+#pragma once
+#include <QRectF>
+#include <QPointF>
+#include <QVector>
+#include <QtMath>
+#include "gameenvironment.h"
+#include "cursorshape.h"
+#include "binaryangle.h"
+
+namespace GameEnvironment
+{
+	//Cursor rect against ring sectors. Points is any container with clear/append/count/operator[],
+	//so fixed-size buffers can share the exact math of the QVector path
+	class Collision
+	{
+	public:
+		enum Outcome { None, Won, Lost };
+
+		static bool touchesRing(const QRectF &rect, double sqrInternalRadius, double sqrExternalRadius);
+		static void distanceRange(const QRectF &rect, double &minSqr, double &maxSqr);//squared distance bounds used by touchesRing
+		static void arcAngles(double fullRotation, double startOffset, double endOffset, double &startAngle, double &endAngle);
+		static bool angleInArc(double pointAngle, double startAngle, double endAngle);
+
+		//the corners of rect that lie in the ring and the crossings of rect edges with both ring radii
+		template<typename Points>
+		static void intersectionPoints(const QRectF &rect, double sqrInternalRadius, double sqrExternalRadius, Points &points);
+
+		template<typename Points>
+		static bool arcHit(const Points &points, double fullRotation, const Arc &arc);
+		template<typename Points>
+		static bool arcHit(const Points &points, double fullRotation, double startOffset, double endOffset);//offsets are the arc ends in radians from the ring rotation
+
+		//first ring from the core outwards that finishes the game, rings are taken at their current rotation
+		static Outcome test(const QVector<Ring> &rings, const QRectF &rect, QVector<QPointF> &points);
+
+		//Convex polygon cursor. The rect path only sees corners and edge crossings, a sector is also hit
+		//when one of its radial edges passes through the polygon, which catches arcs narrower than the cursor
+		static bool touchesRing(const CursorPolygon &polygon, double sqrInternalRadius, double sqrExternalRadius);
+		template<typename Points>
+		static void intersectionPoints(const CursorPolygon &polygon, double sqrInternalRadius, double sqrExternalRadius, Points &points);
+		template<typename Points>
+		static void pointAngles(const Points &points, QVector<double> &angles);//angles of intersection points, shared by all arcs of a ring
+		static bool radialHit(const CursorPolygon &polygon, double angle, double internalRadius, double externalRadius);
+		static bool sectorHit(const CursorPolygon &polygon, const QVector<double> &angles, double fullRotation, const Arc &arc, double internalRadius, double externalRadius);
+		static bool sectorHit(const CursorPolygon &polygon, const QVector<double> &angles, double fullRotation, double startOffset, double endOffset, double internalRadius, double externalRadius);
+		static bool edgeHit(const CursorPolygon &polygon, const QVector<double> &angles, double startAngle, double endAngle, double internalRadius, double externalRadius);//an arc end passes through the polygon
+		static Outcome test(const QVector<Ring> &rings, const CursorPolygon &polygon, QVector<QPointF> &points, QVector<double> &angles);
+
+		//Same point tests with binary angles, the arc is taken from a BinaryAngles::fromArc table built at level load
+		template<typename Points>
+		static void binaryPointAngles(const Points &points, QVector<BinaryAngle> &angles);
+		static bool binaryArcHit(const QVector<BinaryAngle> &angles, BinaryAngle fullRotation, const BinaryArc &arc);
+
+		//seconds until an arc turning at angleSpeed (radians per second) reaches intersection points with these angles
+		static double contactTime(const QVector<double> &angles, double fullRotation, const Arc &arc, double angleSpeed);
+		static double contactTime(const QVector<double> &angles, double fullRotation, double startOffset, double endOffset, double angleSpeed);
+
+	private:
+		template<typename Points>
+		static void addPointIfInsideIntersectedArea(double x, double y, double sqrInternalRadius, double sqrExternalRadius, Points &points);
+		template<typename Points>
+		static void find_and_add_pointsThatIntersectsRadiusInArea_X(double x, double yMin, double yMax, double sqrRadius, Points &points);
+		template<typename Points>
+		static void find_and_add_pointsThatIntersectsRadiusInArea_Y(double y, double xMin, double xMax, double sqrRadius, Points &points);
+	};
+
+	template<typename Points>
+	void Collision::intersectionPoints(const QRectF & rect, double sqrInternalRadius, double sqrExternalRadius, Points & points)
+	{
+		double xMin = rect.x();
+		double yMin = rect.y();
+		double xMax = xMin + rect.width();
+		double yMax = yMin + rect.height();
+
+		addPointIfInsideIntersectedArea(xMin, yMin, sqrInternalRadius, sqrExternalRadius, points);
+		addPointIfInsideIntersectedArea(xMin, yMax, sqrInternalRadius, sqrExternalRadius, points);
+		addPointIfInsideIntersectedArea(xMax, yMin, sqrInternalRadius, sqrExternalRadius, points);
+		addPointIfInsideIntersectedArea(xMax, yMax, sqrInternalRadius, sqrExternalRadius, points);
+
+		find_and_add_pointsThatIntersectsRadiusInArea_X(xMin, yMin, yMax, sqrExternalRadius, points);
+		find_and_add_pointsThatIntersectsRadiusInArea_X(xMax, yMin, yMax, sqrExternalRadius, points);
+		find_and_add_pointsThatIntersectsRadiusInArea_X(xMin, yMin, yMax, sqrInternalRadius, points);
+		find_and_add_pointsThatIntersectsRadiusInArea_X(xMax, yMin, yMax, sqrInternalRadius, points);
+
+		find_and_add_pointsThatIntersectsRadiusInArea_Y(yMin, xMin, xMax, sqrExternalRadius, points);
+		find_and_add_pointsThatIntersectsRadiusInArea_Y(yMax, xMin, xMax, sqrExternalRadius, points);
+		find_and_add_pointsThatIntersectsRadiusInArea_Y(yMin, xMin, xMax, sqrInternalRadius, points);
+		find_and_add_pointsThatIntersectsRadiusInArea_Y(yMax, xMin, xMax, sqrInternalRadius, points);
+	}
+
+	template<typename Points>
+	bool Collision::arcHit(const Points & points, double fullRotation, const Arc & arc)
+	{
+		return arcHit(points, fullRotation, arc.position * 2.0 * M_PI, (arc.position + arc.length)* 2.0 * M_PI);
+	}
+
+	template<typename Points>
+	bool Collision::arcHit(const Points & points, double fullRotation, double startOffset, double endOffset)
+	{
+		double startAngle;
+		double endAngle;
+		arcAngles(fullRotation, startOffset, endOffset, startAngle, endAngle);
+
+		for (int k = 0; k < points.count(); k++)
+		{
+			if (angleInArc(Game::atan4(-points[k].y(), points[k].x()), startAngle, endAngle))
+				return true;
+		}
+		return false;
+	}
+
+	template<typename Points>
+	void Collision::intersectionPoints(const CursorPolygon & polygon, double sqrInternalRadius, double sqrExternalRadius, Points & points)
+	{
+		int count = polygon.vertices.count();
+		for (int i = 0; i < count; i++)
+		{
+			const QPointF &a = polygon.vertices[i];
+			QPointF d = polygon.vertices[(i + 1) % count] - a;
+
+			if (polygon.sqrRadii[i] <= sqrExternalRadius && polygon.sqrRadii[i] >= sqrInternalRadius)
+				points.append(a);
+
+			//|a + t * d|^2 = r^2 for t in [0, 1]
+			double dd = QPointF::dotProduct(d, d);
+			double ad = QPointF::dotProduct(a, d);
+			if (dd == 0)
+				continue;
+			for (double sqrRadius : { sqrInternalRadius, sqrExternalRadius })
+			{
+				double discriminant = ad * ad - dd * (polygon.sqrRadii[i] - sqrRadius);
+				if (discriminant < 0)
+					continue;
+				discriminant = sqrt(discriminant);
+				double t = (-ad - discriminant) / dd;
+				if (t >= 0 && t <= 1)
+					points.append(a + t * d);
+				t = (-ad + discriminant) / dd;
+				if (t >= 0 && t <= 1 && discriminant > 0)
+					points.append(a + t * d);
+			}
+		}
+	}
+
+	template<typename Points>
+	void Collision::pointAngles(const Points & points, QVector<double> & angles)
+	{
+		angles.resize(points.count());
+		for (int k = 0; k < points.count(); k++)
+			angles[k] = Game::atan4(-points[k].y(), points[k].x());
+	}
+
+	template<typename Points>
+	void Collision::binaryPointAngles(const Points & points, QVector<BinaryAngle> & angles)
+	{
+		angles.resize(points.count());
+		for (int k = 0; k < points.count(); k++)
+			angles[k] = BinaryAngles::fromRadians(atan2(-points[k].y(), points[k].x()));
+	}
+
+	template<typename Points>
+	void Collision::addPointIfInsideIntersectedArea(double x, double y, double sqrInternalRadius, double sqrExternalRadius, Points & points)
+	{
+		double sumOfSqr = pow(x, 2.0) + pow(y, 2.0);
+		if (sumOfSqr <= sqrExternalRadius && sumOfSqr >= sqrInternalRadius)
+			points.append(QPointF(x, y));
+	}
+
+	template<typename Points>
+	void Collision::find_and_add_pointsThatIntersectsRadiusInArea_X(double x, double yMin, double yMax, double sqrRadius, Points & points)
+	{
+		double absY = sqrRadius - pow(x, 2.0);
+
+		if (absY >= 0)
+		{
+			absY = sqrt(absY);
+			if (yMax >= absY && yMin <= absY)
+				points.append(QPointF(x, absY));
+			absY = -absY;
+			if (yMax >= absY && yMin <= absY)
+				points.append(QPointF(x, absY));
+		}
+	}
+
+	template<typename Points>
+	void Collision::find_and_add_pointsThatIntersectsRadiusInArea_Y(double y, double xMin, double xMax, double sqrRadius, Points & points)
+	{
+		double absX = sqrRadius - pow(y, 2.0);
+
+		if (absX >= 0)
+		{
+			absX = sqrt(absX);
+			if (xMax >= absX && xMin <= absX)
+				points.append(QPointF(absX, y));
+			absX = -absX;
+			if (xMax >= absX && xMin <= absX)
+				points.append(QPointF(absX, y));
+		}
+	}
+}
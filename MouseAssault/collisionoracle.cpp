@@ -0,0 +1,298 @@
+#include "collisionoracle.h"
+#include "ringintegrator.h"
+#include "cursorshape.h"
+#include <QElapsedTimer>
+#include <QtMath>
+#include <functional>
+#include <random>
+#include <iostream>
+
+using namespace GameEnvironment;
+
+namespace
+{
+	struct FuzzCase
+	{
+		QVector<Ring> rings;//whole rotation in additionalRotation, internalRadius already set
+		QRectF rect;
+	};
+
+	struct Implementation
+	{
+		const char *name;
+		std::function<void(const QVector<Ring> &rings)> prepare;//once per level
+		std::function<Collision::Outcome(const QVector<Ring> &rings, const QRectF &rect, const CursorPolygon &polygon)> test;
+		qint64 time;
+		int mismatches;
+	};
+
+	const char *outcomeName(Collision::Outcome outcome)
+	{
+		return outcome == Collision::Won ? "won" : outcome == Collision::Lost ? "lost" : "none";
+	}
+
+	FuzzCase randomLevel(std::mt19937 &random)
+	{
+		std::uniform_real_distribution<double> unit(0, 1);
+		FuzzCase level;
+		int ringCount = 2 + random() % 10;
+		int radius = 0;
+		for (int i = 0; i < ringCount; i++)
+		{
+			Ring ring(i == 0 ? 10 + random() % 50 : 2 + random() % 60, 0, 0, (unit(random) - 0.5) * 8 * M_PI);
+			int arcs = i == 0 ? 0 : random() % 5;
+			for (int j = 0; j < arcs; j++)
+			{
+				//narrow arcs slip between the corners of a cursor, wide ones wrap past zero
+				double length = j % 3 == 0 ? unit(random) * 0.01 : j % 3 == 1 ? unit(random) * 0.3 : unit(random) * 0.95;
+				ring.arcs.append({ unit(random), length });
+			}
+			ring.internalRadius = radius;
+			radius += ring.width;
+			level.rings.append(ring);
+		}
+		return level;
+	}
+
+	QRectF randomRect(const QVector<Ring> &rings, std::mt19937 &random)
+	{
+		std::uniform_real_distribution<double> unit(0, 1);
+		double radius = (rings.last().internalRadius + rings.last().width + 20) * unit(random);
+		double angle = unit(random) * 2 * M_PI;
+		double scale = 0.2 + unit(random) * 3;
+		return QRectF(radius * cos(angle) - 5 * scale, radius * sin(angle) - 9 * scale, 10 * scale, 18 * scale);
+	}
+
+	//drops rings and arcs and shrinks the rect to one of its quarters for as long as the case keeps failing
+	FuzzCase minimize(FuzzCase failing, const std::function<bool(const FuzzCase &)> &fails)
+	{
+		bool shrunk = true;
+		while (shrunk)
+		{
+			shrunk = false;
+			for (int i = failing.rings.count() - 1; i >= 1; i--)
+			{
+				FuzzCase smaller = failing;
+				smaller.rings.remove(i);
+				if (fails(smaller))
+				{
+					failing = smaller;
+					shrunk = true;
+				}
+			}
+			for (int i = 0; i < failing.rings.count(); i++)
+			{
+				for (int j = failing.rings[i].arcs.count() - 1; j >= 0; j--)
+				{
+					FuzzCase smaller = failing;
+					smaller.rings[i].arcs.remove(j);
+					if (fails(smaller))
+					{
+						failing = smaller;
+						shrunk = true;
+					}
+				}
+			}
+			double halfWidth = failing.rect.width() / 2;
+			double halfHeight = failing.rect.height() / 2;
+			//quarters keep the aspect the polygon cursor is scaled to
+			const QRectF cuts[] = { failing.rect.adjusted(0, 0, -halfWidth, -halfHeight), failing.rect.adjusted(halfWidth, 0, 0, -halfHeight),
+				failing.rect.adjusted(0, halfHeight, -halfWidth, 0), failing.rect.adjusted(halfWidth, halfHeight, 0, 0) };
+			for (const QRectF &cut : cuts)
+			{
+				FuzzCase smaller = failing;
+				smaller.rect = cut;
+				if (smaller.rect.width() > 1e-3 && smaller.rect.height() > 1e-3 && fails(smaller))
+				{
+					failing = smaller;
+					shrunk = true;
+				}
+			}
+		}
+		return failing;
+	}
+
+	void printCase(const FuzzCase &repro, std::ostream &out)
+	{
+		out.precision(17);
+		for (const Ring &ring : repro.rings)
+		{
+			out << "    ring radius " << ring.internalRadius << " width " << ring.width << " rotation " << ring.additionalRotation << " arcs";
+			for (const Arc &arc : ring.arcs)
+				out << " (" << arc.position << ", " << arc.length << ")";
+			out << std::endl;
+		}
+		out << "    rect " << repro.rect.x() << ' ' << repro.rect.y() << ' ' << repro.rect.width() << ' ' << repro.rect.height() << std::endl;
+		out.precision(6);
+	}
+}
+
+Collision::Outcome CollisionOracle::test(const QVector<Ring>& rings, const QRectF & rect, int samplesPerAxis)
+{
+	for (int i = 0; i < rings.count(); i++)
+	{
+		const Ring &ring = rings[i];
+		double inner = ring.internalRadius;
+		double outer = ring.internalRadius + ring.width;
+		double rotation = ring.additionalRotation + ring.rotation;
+		bool inRing = false;
+		for (int sx = 0; sx <= samplesPerAxis; sx++)
+		{
+			double x = rect.x() + rect.width() * sx / samplesPerAxis;
+			for (int sy = 0; sy <= samplesPerAxis; sy++)
+			{
+				double y = rect.y() + rect.height() * sy / samplesPerAxis;
+				double radius = sqrt(x * x + y * y);
+				if (radius < inner || radius > outer)
+					continue;
+				inRing = true;
+
+				//counterclockwise with y pointing up, the way the rings are drawn
+				double angle = atan2(-y, x);
+				for (const Arc &arc : ring.arcs)
+				{
+					double fromStart = fmod(angle - rotation - arc.position * 2 * M_PI, 2 * M_PI);
+					if (fromStart < 0)
+						fromStart += 2 * M_PI;
+					if (fromStart > 0 && fromStart < arc.length * 2 * M_PI)
+						return Collision::Lost;
+				}
+			}
+		}
+		if (inRing && i == 0)
+			return Collision::Won;
+
+		//the same grid across every sector finds arcs too narrow for the grid of the rect
+		for (const Arc &arc : ring.arcs)
+		{
+			for (int sa = 0; sa < samplesPerAxis; sa++)
+			{
+				double angle = rotation + (arc.position + arc.length * (sa + 0.5) / samplesPerAxis) * 2 * M_PI;
+				for (int sr = 0; sr <= samplesPerAxis; sr++)
+				{
+					double radius = inner + (outer - inner) * sr / samplesPerAxis;
+					QPointF point(radius * cos(angle), -radius * sin(angle));
+					if (point.x() >= rect.left() && point.x() <= rect.right() && point.y() >= rect.top() && point.y() <= rect.bottom())
+						return Collision::Lost;
+				}
+			}
+		}
+	}
+	return Collision::None;
+}
+
+int CollisionOracle::fuzz(const QStringList & arguments)
+{
+	//--seed <n> --levels <n> --queries <per level> --samples <per axis> --repros <per implementation>
+	auto value = [&arguments](const char *option, int fallback) {
+		int index = arguments.indexOf(option);
+		return index >= 0 && index + 1 < arguments.count() ? arguments[index + 1].toInt() : fallback;
+	};
+	std::mt19937 random(value("--seed", 1));
+	int levels = qMax(1, value("--levels", 50));
+	int queries = qMax(1, value("--queries", 200));
+	int samples = qMax(2, value("--samples", 48));
+	int repros = value("--repros", 2);
+
+	QVector<QPointF> points;
+	QVector<double> angles;
+	QVector<Ring> target;
+	RingIntegrator integrator;
+	RingIntegrator binaryIntegrator;
+	integrator.setThreadCount(1);
+	binaryIntegrator.setThreadCount(1);
+	const RingStep step = { 0, 0, 0, false, false, false, QRectF(), nullptr };
+	auto integrate = [&](RingIntegrator &ringIntegrator, const QVector<Ring> &rings, const QRectF &rect) {
+		RingStep rectStep = step;
+		rectStep.mouseRect = rect;
+		double horizon = INFINITY;
+		int finisher = ringIntegrator.integrate(rings, target, rectStep, horizon);
+		return finisher < 0 ? Collision::None : finisher == 0 ? Collision::Won : Collision::Lost;
+	};
+
+	QVector<Implementation> implementations = {
+		{ "rect", [](const QVector<Ring> &) {},
+			[&](const QVector<Ring> &rings, const QRectF &rect, const CursorPolygon &) { return Collision::test(rings, rect, points); }, 0, 0 },
+		{ "polygon", [](const QVector<Ring> &) {},
+			[&](const QVector<Ring> &rings, const QRectF &, const CursorPolygon &polygon) { return Collision::test(rings, polygon, points, angles); }, 0, 0 },
+		{ "tick", [](const QVector<Ring> &) {},
+			[&](const QVector<Ring> &rings, const QRectF &rect, const CursorPolygon &) { return integrate(integrator, rings, rect); }, 0, 0 },
+		{ "binary tick", [&](const QVector<Ring> &rings) { binaryIntegrator.setBinaryArcs(rings); },
+			[&](const QVector<Ring> &rings, const QRectF &rect, const CursorPolygon &) { return integrate(binaryIntegrator, rings, rect); }, 0, 0 },
+	};
+
+	CursorShape rectShape({ { 0, 0 }, { 10, 0 }, { 10, 18 }, { 0, 18 } });
+	auto evaluate = [&](Implementation &implementation, const FuzzCase &fuzzCase) {
+		CursorPolygon polygon;
+		rectShape.place(fuzzCase.rect, polygon);
+		implementation.prepare(fuzzCase.rings);
+		return implementation.test(fuzzCase.rings, fuzzCase.rect, polygon);
+	};
+	//a disagreement a finer grid takes back is a sampling gap, not a mismatch
+	auto disagrees = [&](Collision::Outcome outcome, const FuzzCase &fuzzCase) {
+		for (int refinement : { 1, 4, 16 })
+		{
+			if (outcome == test(fuzzCase.rings, fuzzCase.rect, samples * refinement))
+				return false;
+		}
+		return true;
+	};
+
+	QVector<QRectF> rects(queries);
+	QVector<CursorPolygon> polygons(queries);
+	QVector<char> expected(queries);
+	QVector<char> outcomes(queries);
+	qint64 oracleTime = 0;
+	QElapsedTimer timer;
+	for (int level = 0; level < levels; level++)
+	{
+		FuzzCase fuzzCase = randomLevel(random);
+		for (int i = 0; i < queries; i++)
+		{
+			rects[i] = randomRect(fuzzCase.rings, random);
+			rectShape.place(rects[i], polygons[i]);
+		}
+
+		timer.start();
+		for (int i = 0; i < queries; i++)
+			expected[i] = test(fuzzCase.rings, rects[i], samples);
+		oracleTime += timer.nsecsElapsed();
+
+		for (Implementation &implementation : implementations)
+		{
+			implementation.prepare(fuzzCase.rings);
+			timer.restart();
+			for (int i = 0; i < queries; i++)
+				outcomes[i] = implementation.test(fuzzCase.rings, rects[i], polygons[i]);
+			implementation.time += timer.nsecsElapsed();
+
+			for (int i = 0; i < queries; i++)
+			{
+				fuzzCase.rect = rects[i];
+				if (outcomes[i] == expected[i] || !disagrees(Collision::Outcome(outcomes[i]), fuzzCase))
+					continue;
+				if (implementation.mismatches++ >= repros)
+					continue;
+
+				FuzzCase repro = minimize(fuzzCase, [&](const FuzzCase &candidate) {
+					return disagrees(evaluate(implementation, candidate), candidate);
+				});
+				Collision::Outcome reproOutcome = evaluate(implementation, repro);
+				std::cout << implementation.name << " says " << outcomeName(reproOutcome) << ", oracle says "
+					<< outcomeName(test(repro.rings, repro.rect, samples * 16)) << ":" << std::endl;
+				printCase(repro, std::cout);
+			}
+		}
+	}
+
+	int total = levels * queries;
+	std::cout << total << " queries, oracle " << samples << "x" << samples << " samples: " << total / (oracleTime / 1e9) << " queries/s" << std::endl;
+	bool clean = true;
+	for (const Implementation &implementation : implementations)
+	{
+		std::cout << implementation.name << ": " << total / (implementation.time / 1e9) << " queries/s, "
+			<< implementation.mismatches << " mismatches" << std::endl;
+		clean = clean && implementation.mismatches == 0;
+	}
+	return clean ? 0 : 1;
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include <QVector>
+#include <QRectF>
+#include <QStringList>
+#include "gameenvironment.h"
+#include "collision.h"
+
+namespace GameEnvironment
+{
+	//Ground truth for cursor collisions. A grid of points across the cursor rect is tested for lying in a ring and
+	//strictly inside one of its arcs, and a grid across every arc sector for lying in the rect. None of the geometry
+	//Collision uses is shared
+	class CollisionOracle
+	{
+	public:
+		static Collision::Outcome test(const QVector<Ring> &rings, const QRectF &rect, int samplesPerAxis);
+
+		//--fuzz command line mode, random levels and cursors through every collision path against the oracle
+		static int fuzz(const QStringList &arguments);
+	};
+}
@@ -0,0 +1,157 @@
+#include "cursorshape.h"
+#include <QStringList>
+#include <algorithm>
+
+using namespace GameEnvironment;
+
+static double cross(const QPointF &o, const QPointF &a, const QPointF &b)
+{
+	return (a.x() - o.x()) * (b.y() - o.y()) - (a.y() - o.y()) * (b.x() - o.x());
+}
+
+static double sqrDistanceToSegment(const QPointF &a, const QPointF &b)
+{
+	QPointF d = b - a;
+	double length = QPointF::dotProduct(d, d);
+	double t = length > 0 ? qBound(0.0, -QPointF::dotProduct(a, d) / length, 1.0) : 0;
+	QPointF closest = a + t * d;
+	return QPointF::dotProduct(closest, closest);
+}
+
+CursorShape::CursorShape()
+{
+}
+
+CursorShape::CursorShape(const QVector<QPointF> & outline)
+{
+	//monotone chain
+	QVector<QPointF> points = outline;
+	std::sort(points.begin(), points.end(), [](const QPointF &a, const QPointF &b) {
+		return a.x() < b.x() || (a.x() == b.x() && a.y() < b.y());
+	});
+
+	QVector<QPointF> chain(2 * points.count());
+	int k = 0;
+	for (int i = 0; i < points.count(); i++)
+	{
+		while (k >= 2 && cross(chain[k - 2], chain[k - 1], points[i]) <= 0)
+			k--;
+		chain[k++] = points[i];
+	}
+	for (int i = points.count() - 2, lower = k + 1; i >= 0; i--)
+	{
+		while (k >= lower && cross(chain[k - 2], chain[k - 1], points[i]) <= 0)
+			k--;
+		chain[k++] = points[i];
+	}
+	hull = chain.mid(0, qMax(k - 1, 0));
+	if (hull.count() < 3)
+	{
+		hull.clear();
+		return;
+	}
+
+	double xMin = hull[0].x(), xMax = xMin, yMin = hull[0].y(), yMax = yMin;
+	for (int i = 0; i < hull.count(); i++)
+	{
+		const QPointF &a = hull[i];
+		const QPointF &b = hull[(i + 1) % hull.count()];
+		//counter-clockwise in a y-up frame, so the right-hand normal points outwards
+		QPointF normal(b.y() - a.y(), a.x() - b.x());
+		normals.append(normal);
+		offsets.append(QPointF::dotProduct(normal, a));
+
+		xMin = qMin(xMin, a.x());
+		xMax = qMax(xMax, a.x());
+		yMin = qMin(yMin, a.y());
+		yMax = qMax(yMax, a.y());
+	}
+	bounds = QSizeF(xMax - xMin, yMax - yMin);
+}
+
+CursorShape CursorShape::arrow()
+{
+	//fills the 10x18 cursor rect of GameWindow
+	return CursorShape({ { 0, 0 }, { 0, 15 }, { 4, 18 }, { 6.5, 17.5 }, { 10, 10.5 } });
+}
+
+bool CursorShape::fromString(const QString & text, CursorShape & shape)
+{
+	if (text == "rect")
+	{
+		shape = CursorShape();
+		return true;
+	}
+	if (text == "arrow")
+	{
+		shape = arrow();
+		return true;
+	}
+
+	QVector<QPointF> outline;
+	QStringList points = text.split(' ', QString::SkipEmptyParts);
+	for (int i = 0; i < points.count(); i++)
+	{
+		QStringList coordinates = points[i].split(',');
+		if (coordinates.count() != 2)
+			return false;
+		outline.append(QPointF(coordinates[0].toDouble(), coordinates[1].toDouble()));
+	}
+
+	shape = CursorShape(outline);
+	return !shape.isEmpty();
+}
+
+bool CursorShape::isEmpty() const
+{
+	return hull.isEmpty();
+}
+
+QSizeF CursorShape::size() const
+{
+	return bounds;
+}
+
+void CursorShape::place(const QRectF & rect, CursorPolygon & polygon)
+{
+	double scale = bounds.width() > 0 ? rect.width() / bounds.width() : 1;
+	if (scale != cachedScale)
+	{
+		scaledHull.resize(hull.count());
+		scaledOffsets.resize(hull.count());
+		for (int i = 0; i < hull.count(); i++)
+		{
+			scaledHull[i] = hull[i] * scale;
+			scaledOffsets[i] = offsets[i] * scale;
+		}
+		cachedScale = scale;
+	}
+
+	QPointF corner = rect.topLeft();
+	int count = scaledHull.count();
+	polygon.vertices.resize(count);
+	polygon.normals = normals;
+	polygon.offsets.resize(count);
+	polygon.sqrRadii.resize(count);
+
+	bool containsCenter = true;
+	polygon.minSqr = INFINITY;
+	polygon.maxSqr = 0;
+	for (int i = 0; i < count; i++)
+	{
+		QPointF vertex = scaledHull[i] + corner;
+		polygon.vertices[i] = vertex;
+		polygon.offsets[i] = scaledOffsets[i] + QPointF::dotProduct(normals[i], corner);
+		polygon.sqrRadii[i] = QPointF::dotProduct(vertex, vertex);
+		polygon.maxSqr = qMax(polygon.maxSqr, polygon.sqrRadii[i]);
+		containsCenter = containsCenter && polygon.offsets[i] >= 0;
+	}
+
+	if (containsCenter)
+		polygon.minSqr = 0;
+	else
+	{
+		for (int i = 0; i < count; i++)
+			polygon.minSqr = qMin(polygon.minSqr, sqrDistanceToSegment(polygon.vertices[i], polygon.vertices[(i + 1) % count]));
+	}
+}
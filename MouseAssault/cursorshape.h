@@ -0,0 +1,45 @@
+#pragma once
+#include <QVector>
+#include <QPointF>
+#include <QRectF>
+#include <QSizeF>
+#include <QString>
+
+namespace GameEnvironment
+{
+	//Convex cursor outline placed in level coordinates, everything Collision needs is precomputed
+	struct CursorPolygon
+	{
+		QVector<QPointF> vertices;
+		QVector<QPointF> normals;//outward, normals[i] belongs to the edge from vertices[i] to vertices[i + 1]
+		QVector<double> offsets;//a point is inside when normals[i] * point <= offsets[i] for every edge
+		QVector<double> sqrRadii;//squared distance of every vertex from the center
+		double minSqr = 0;
+		double maxSqr = 0;
+	};
+
+	//Cursor outline in window pixels with the hot spot at (0, 0), only its convex hull is kept.
+	//Edge normals are computed once, the scaled hull once per scale factor, moving the cursor only offsets it
+	class CursorShape
+	{
+	public:
+		CursorShape();//no outline, the game keeps testing the cursor rect
+		CursorShape(const QVector<QPointF> &outline);
+		static CursorShape arrow();
+		static bool fromString(const QString &text, CursorShape &shape);//"rect", "arrow" or "x,y x,y ..."
+
+		bool isEmpty() const;
+		QSizeF size() const;
+		void place(const QRectF &rect, CursorPolygon &polygon);//hull scaled to rect width and moved to its top left corner
+
+	private:
+		QVector<QPointF> hull;
+		QVector<QPointF> normals;
+		QVector<double> offsets;
+		QSizeF bounds;
+
+		double cachedScale = -1;
+		QVector<QPointF> scaledHull;
+		QVector<double> scaledOffsets;
+	};
+}
@@ -0,0 +1,201 @@
+#include "gamedata.h"
+#include <QFile>
+#include <QTextStream>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QtMath>
+#include <random>
+
+using namespace GameEnvironment;
+
+static StaticRingIntegration *testLevelIntegration()
+{
+	return new StaticLevelIntegration<7, 6>(testLevelTable);
+}
+
+GameSettings GameEnvironment::testLevel()
+{
+	GameSettings testSettings;
+	testSettings.rings = testLevelTable.toRings();
+	testSettings.staticIntegration = testLevelIntegration;
+
+	testSettings.ringColors.append(Qt::blue);
+	testSettings.ringColors.append(Qt::yellow);
+	testSettings.ringColors.append(Qt::red);
+	testSettings.ringColors.append(Qt::GlobalColor::red);
+	testSettings.ringColors.append(Qt::green);
+	testSettings.ringColors.append(Qt::blue);
+
+	testSettings.energyCircutColor = Qt::transparent;
+	testSettings.energyColor = Qt::blue;
+	testSettings.freezeColor = Qt::red;
+	testSettings.energyRegenirationSpeed = 0.3;
+	testSettings.freezeRegenirationSpeed = 0.3;
+	testSettings.energyVolume = 4;
+	testSettings.freezeVolume = 5;
+	testSettings.goodClearingSpeed = -3;
+	testSettings.goodSpreadingSpeed = 3;
+	testSettings.goodColor = Qt::white;
+	testSettings.ringSelectingSpeed = 1.5;
+	testSettings.selectedRingBackgroundColor = Qt::gray;
+
+	return testSettings;
+}
+
+GameSettings GameEnvironment::stressLevel(int ringCount, unsigned seed)
+{
+	GameSettings settings = testLevel();
+	settings.rings.resize(1);
+	settings.staticIntegration = nullptr;//the rings are not the test level table
+
+	int testColors = settings.ringColors.count();
+	std::mt19937 random(seed);
+	std::uniform_int_distribution<int> width(1, 3);
+	std::uniform_real_distribution<double> speed(-M_PI, M_PI);
+	std::uniform_real_distribution<double> unit(0, 1);
+	for (int i = 0; i < ringCount; i++)
+	{
+		Ring ring(width(random), speed(random), 0, unit(random) * 2 * M_PI);
+		double position = unit(random);
+		int arcs = 1 + i % 3;
+		for (int j = 0; j < arcs; j++)
+		{
+			double length = unit(random) * 0.2 / arcs;
+			ring.arcs.append({ position - floor(position), length });
+			position += length + unit(random) * 0.5 / arcs;
+		}
+		settings.rings.append(ring);
+		if (i >= testColors)
+			settings.ringColors.append(settings.ringColors[i % testColors]);//one brush per ring, the test palette repeats
+	}
+	return settings;
+}
+
+bool GameEnvironment::loadLevel(const QString & level, GameSettings & settings)
+{
+	if (level == "test")
+	{
+		settings = testLevel();
+		return true;
+	}
+
+	QFile file(level);
+	if (!file.open(QIODevice::ReadOnly))
+		return false;
+
+	QJsonDocument document = QJsonDocument::fromJson(file.readAll());
+	if (!document.isObject())
+		return false;
+
+	QJsonObject json = document.object();
+	QJsonArray rings = json["rings"].toArray();
+	if (rings.isEmpty())
+		return false;
+
+	settings = GameSettings();
+	for (int i = 0; i < rings.count(); i++)
+	{
+		QJsonObject ringJson = rings[i].toObject();
+		Ring ring(ringJson["width"].toInt(25), ringJson["angleSpeed"].toDouble(), 0, ringJson["additionalRotation"].toDouble());
+
+		QJsonArray arcs = ringJson["arcs"].toArray();
+		for (int j = 0; j < arcs.count(); j++)
+		{
+			QJsonArray arc = arcs[j].toArray();
+			ring.arcs.append({ arc[0].toDouble(), arc[1].toDouble() });
+		}
+		settings.rings.append(ring);
+	}
+
+	QJsonArray ringColors = json["ringColors"].toArray();
+	for (int i = 0; i < ringColors.count(); i++)
+		settings.ringColors.append(QColor(ringColors[i].toString()));
+	while (settings.ringColors.count() < settings.rings.count() - 1)
+		settings.ringColors.append(Qt::blue);
+
+	settings.goodColor = QColor(json["goodColor"].toString("white"));
+	settings.selectedRingBackgroundColor = QColor(json["selectedRingBackgroundColor"].toString("gray"));
+	settings.energyCircutColor = QColor(json["energyCircutColor"].toString("transparent"));
+	settings.energyColor = QColor(json["energyColor"].toString("blue"));
+	settings.freezeColor = QColor(json["freezeColor"].toString("red"));
+
+	settings.ringSelectingSpeed = json["ringSelectingSpeed"].toDouble(1.5);
+	settings.goodSpreadingSpeed = json["goodSpreadingSpeed"].toDouble(3);
+	settings.goodClearingSpeed = json["goodClearingSpeed"].toDouble(-3);
+	settings.energyRegenirationSpeed = json["energyRegenirationSpeed"].toDouble(0.3);
+	settings.freezeRegenirationSpeed = json["freezeRegenirationSpeed"].toDouble(0.3);
+	settings.energyVolume = json["energyVolume"].toDouble(4);
+	settings.freezeVolume = json["freezeVolume"].toDouble(5);
+	settings.binaryAngles = json["binaryAngles"].toBool(false);
+	return true;
+}
+
+bool GameEnvironment::saveInputRecording(const QString & path, const InputRecording & recording)
+{
+	QFile file(path);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+		return false;
+
+	QTextStream out(&file);
+	out.setRealNumberPrecision(10);
+	for (int i = 0; i < recording.count(); i++)
+	{
+		const InputEvent &event = recording[i];
+		out << event.time << ' ' << int(event.type);
+		if (event.type == InputEvent::MouseMove)
+			out << ' ' << event.rect.x() << ' ' << event.rect.y() << ' ' << event.rect.width() << ' ' << event.rect.height();
+		else if (event.type == InputEvent::Rewind)
+			out << ' ' << event.seconds;
+		out << '\n';
+	}
+	return true;
+}
+
+bool GameEnvironment::loadInputRecording(const QString & path, InputRecording & recording)
+{
+	QFile file(path);
+	if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+		return false;
+
+	recording.clear();
+	QTextStream in(&file);
+	while (!in.atEnd())
+	{
+		QStringList fields = in.readLine().split(' ', QString::SkipEmptyParts);
+		if (fields.isEmpty())
+			continue;
+		if (fields.count() < 2)
+			return false;
+
+		InputEvent event;
+		event.time = fields[0].toInt();
+		event.type = InputEvent::Type(fields[1].toInt());
+		if (event.type == InputEvent::MouseMove)
+		{
+			if (fields.count() < 6)
+				return false;
+			event.rect.setRect(fields[2].toDouble(), fields[3].toDouble(), fields[4].toDouble(), fields[5].toDouble());
+		}
+		else if (event.type == InputEvent::Rewind)
+		{
+			if (fields.count() < 3)
+				return false;
+			event.seconds = fields[2].toDouble();
+		}
+		recording.append(event);
+	}
+	return true;
+}
+
+bool GameEnvironment::saveRunClaim(const QString & path, const QString & level, bool won, int time)
+{
+	QFile file(path);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+		return false;
+
+	//<level> won|lost <ms>, level relative to the directory of the claim
+	QTextStream out(&file);
+	out << level << ' ' << (won ? "won" : "lost") << ' ' << time << '\n';
+	return true;
+}
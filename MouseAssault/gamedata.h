@@ -0,0 +1,27 @@
+#pragma once
+#include <QString>
+#include "gameenvironment.h"
+#include "staticlevel.h"
+
+namespace GameEnvironment
+{
+	constexpr StaticLevel<7, 6> testLevelTable = { {
+		{ 40, 0, 0, 0, {} },
+		{ 30, M_PI / 2, 0, 2, { { 0, 0.3 }, { 0.6, 0.2 } } },
+		{ 35, -M_PI / 4.0, M_PI / 4, 1, { { 0, 0.8 } } },
+		{ 40, -M_PI / 2, 0, 2, { { 0.4, 0.1 }, { 0.6, 0.3 } } },
+		{ 35, 0, 0, 2, { { 0.1, 0.4 }, { 0.6, 0.4 } } },
+		{ 40, M_PI / 6, 0.1 * M_PI, 6, { { 0, 0.1 }, { 0.3, 0.05 }, { 0.39, 0.1 }, { 0.6, 0.05 }, { 0.7, 0.01 }, { 0.78, 0.2 } } },
+		{ 50, -M_PI / 2, M_PI, 3, { { 0, 0.3 }, { 0.5, 0.2 }, { 0.8, 0.1 } } }
+	} };
+
+	GameSettings testLevel();
+	GameSettings stressLevel(int ringCount, unsigned seed);//testLevel colors and speeds with thin random rings
+
+	//level is either the name of a built-in level or a path to a json level file
+	bool loadLevel(const QString &level, GameSettings &settings);
+
+	bool saveInputRecording(const QString &path, const InputRecording &recording);
+	bool loadInputRecording(const QString &path, InputRecording &recording);
+	bool saveRunClaim(const QString &path, const QString &level, bool won, int time);//the outcome --validate checks a recording against
+}
@@ -1,26 +1,37 @@
 #include "gameenvironment.h"
+#include "collision.h"
+#include "statepublisher.h"
+#include "jitterprofiler.h"
+#include "latencyprobe.h"
+#include "ringintegrator.h"
+#include "rendercache.h"
+#include <QElapsedTimer>
 #include <QtMath>
 #include <iostream>
 
 using namespace GameEnvironment;
 
 
-Game::Game(GameSettings s)
+GameLevel::GameLevel(const GameSettings & s) : settings(s)
 {
-	settings = s;
-	
-	gameCircle = new Circle(settings.rings[0].width);
+	initialCircle = new Circle(settings.rings[0].width);
 
 	for (int i = 1; i < settings.rings.count(); i++)
 	{
-		gameCircle->addRing(settings.rings[i]);
+		initialCircle->addRing(settings.rings[i]);
+	}
+
+	for (int i = 0; i < initialCircle->count(); i++)
+	{
+		initialCircle->addRingRotation(i, initialCircle->at(i).additionalRotation);
+		initialCircle->moveRing(i, 0);
 	}
 
 	resources.goodBrush = new QBrush(settings.goodColor);
-	resources.fromGoodToEvilGradient = new QRadialGradient(0, 0, gameCircle->at(0).width);
+	resources.fromGoodToEvilGradient = new QRadialGradient(0, 0, initialCircle->at(0).width);
 	resources.fromGoodToEvilGradient->setColorAt(0, settings.goodColor);
-	resources.fromGoodToEvilGradient->setColorAt(goodColorBefore, settings.goodColor);
-	resources.fromGoodToEvilGradient->setColorAt(evilColorAt, Qt::transparent);
+	resources.fromGoodToEvilGradient->setColorAt(Game::goodColorBefore, settings.goodColor);
+	resources.fromGoodToEvilGradient->setColorAt(Game::evilColorAt, Qt::transparent);
 
 	for (int i = 0; i < settings.ringColors.count(); i++)
 		resources.ringBrushes.append(new QBrush(settings.ringColors[i]));
@@ -28,139 +39,171 @@ Game::Game(GameSettings s)
 	resources.circutPen = new QPen(settings.energyCircutColor);
 	resources.energyBrush = new QBrush(settings.energyColor);
 	resources.freezeBrush = new QBrush(settings.freezeColor);
+	renderCache = new RenderCache(settings.selectedRingBackgroundColor, *resources.fromGoodToEvilGradient, settings.rings[0].width);
+
+	initialState.currentEnergyVolume = settings.energyVolume;
+	initialState.currentFreezeVolume = settings.freezeVolume;
 }
 
-Game::~Game()
+GameLevel::~GameLevel()
 {
-	delete gameCircle;
+	delete initialCircle;
+	delete renderCache;
 	delete resources.goodBrush;
 	delete resources.fromGoodToEvilGradient;
 	delete resources.circutPen;
 	delete resources.energyBrush;
 	delete resources.freezeBrush;
 	qDeleteAll(resources.ringBrushes);
+}
 
+Game::Game(GameSettings s) : Game(new GameLevel(s))
+{
+}
+
+Game::Game(GameLevel * first) : level(first), paintLevel(first)
+{
+	gameCircle = new Circle(*level->initialCircle);
+	ringIntegrator = new RingIntegrator();
+	if (level->settings.binaryAngles)
+		ringIntegrator->setBinaryArcs(gameCircle->ringList());
+	if (level->settings.staticIntegration)
+		ringIntegrator->setStaticIntegration(level->settings.staticIntegration());
+
+	state = level->initialState;
+	publishCommands();
+}
+
+Game::~Game()
+{
+	delete gameCircle;
+	delete ringIntegrator;
+	delete level;
+	delete pendingLevel;
+	qDeleteAll(retiredLevels);
 }
 
 void Game::setMouseRect(QRectF rect)
 {
 	QMutexLocker locker(&inputMutex);
 	mouseRect = rect;
+	record(InputEvent::MouseMove, rect);
+	notifyInput();
+}
+
+void Game::setCursorShape(const CursorShape & shape)
+{
+	QMutexLocker locker(&inputMutex);
+	cursorShape = shape;
+	placeCursor = true;
+	notifyInput();
 }
 
 void Game::startRingDragging()
 {
 	QMutexLocker locker(&inputMutex);
 	leftMButtonPressed = true;
+	record(InputEvent::StartRingDragging);
+	notifyInput();
 }
 
 void Game::stopRingDragging()
 {
 	QMutexLocker locker(&inputMutex);
 	leftMButtonPressed = false;
+	record(InputEvent::StopRingDragging);
+	notifyInput();
 }
 
 void Game::freeze()
 {
 	QMutexLocker locker(&inputMutex);
 	rightMButtonPressed = true;
+	record(InputEvent::Freeze);
+	notifyInput();
 }
 
 void Game::unfreeze()
 {
 	QMutexLocker locker(&inputMutex);
 	rightMButtonPressed = false;
+	record(InputEvent::Unfreeze);
+	notifyInput();
 }
 
-void Game::draw(double cornerDist,QPainter & painter)
+void Game::rewind(double seconds)
 {
+	QMutexLocker locker(&inputMutex);
+	rewindSeconds += seconds;
+	record(InputEvent::Rewind, QRectF(), seconds);
+	notifyInput();
+}
 
-	circleMutex.lock();
-	int radius = gameCircle->totalRadius();
-	for (int i = gameCircle->count() - 1; i > 0; i--)
+void Game::draw(double cornerDist,QPainter & painter)
+{
+	//only the swap is locked, the simulation can publish while the list is replayed
+	commandsMutex.lock();
+	if (readyPublished)
 	{
-		Ring ring = gameCircle->at(i);
-		circleMutex.unlock();
-		double ringRotation = ring.rotation + ring.additionalRotation;
-		if (ring.selectedScore > 0)
-		{
-			QColor selectionColor = settings.selectedRingBackgroundColor;
-			selectionColor.setAlphaF(ring.selectedScore);
-			painter.setBrush(selectionColor);
-			painter.drawEllipse(-radius,
-				-radius,
-				radius * 2,
-				radius * 2);
-		}
-		for (int j = 0; j < ring.arcs.length(); j++)
-		{
-			Arc arc = ring.arcs[j];
-			double nextRadius = radius - ring.width;
-
-
-			painter.setBrush(*resources.ringBrushes[i - 1]);
-			painter.drawPie(-radius,
-				-radius,
-				radius *2,
-				radius *2,
-				qRadiansToDegrees(ringRotation + arc.position * M_PI * 2) * 16,
-				qRadiansToDegrees(2 * M_PI * arc.length) * 16
-			);
-			painter.setBrush(QBrush(painter.background()));
-			painter.drawEllipse(-nextRadius, -nextRadius, nextRadius * 2, nextRadius * 2);
-#ifdef QT_DEBUG
-			painter.save();
-			painter.setPen(QColor(Qt::yellow));
-			painter.setBrush(Qt::BrushStyle::NoBrush);
-			
-			double s_ang = ringRotation + arc.position * M_PI * 2;
-			double e_ang = s_ang + arc.length * 2.0 *M_PI;
-
-			painter.drawLine(0, 0, 250.0 * cos(s_ang), 250.0 * -sin(s_ang));
-			painter.drawLine(0, 0, 250.0 * cos(e_ang), 250.0 * -sin(e_ang));
+		frontCommands.swap(readyCommands);
+		paintLevel = frontCommands.level;
+		readyPublished = false;
+	}
+	double elapsed = clock.isValid() ? qMax(0.0, clock.elapsed() - frontCommands.motion.time) : 0;
+	commandsMutex.unlock();
 
-			painter.restore();
-#endif
-		}
-		radius -= ring.width;
-		circleMutex.lock();
+	qint64 drawStart = latencyProbe ? latencyProbe->now() : 0;
+	replay(frontCommands, elapsed, cornerDist, painter);
+	if (latencyProbe && frontCommands.latency.input >= 0)
+	{
+		latencyProbe->record(frontCommands.latency, drawStart, latencyProbe->now());
+		frontCommands.latency = LatencyStamp();
 	}
-	circleMutex.unlock();
-	drawCore(cornerDist, painter);
 
 #ifdef QT_DEBUG
+	if (debugDrawing)
+		drawDebug(frameState(), painter);
+#endif // QT_DEBUG
+}
 
-	painter.setPen(QColor(Qt::yellow));
-	painter.setBrush(Qt::BrushStyle::NoBrush);
-	circleMutex.lock();
-	painter.drawRect(mouseRect);
-	circleMutex.unlock();
+void Game::draw(const FrameState & frame, double cornerDist, QPainter & painter)
+{
+	RenderCommandList commands;
+	commands.build(frame.rings, frame.coreWidthScore, frame.gameWon);
+	commands.level = level;
+	replay(commands, 0, cornerDist, painter);
 
-	painter.setPen(QColor(Qt::red));
+#ifdef QT_DEBUG
+	if (debugDrawing)
+		drawDebug(frame, painter);
+#endif // QT_DEBUG
+}
 
-	double angle;
+void Game::drawUI(double width, double height, QPainter & painter)
+{
+	FrameState frame;
 
 	circleMutex.lock();
-
-	for (int i = 0; i < arcIntersectedPoints.count(); i++)
-	{
-		radius = sqrt(pow(arcIntersectedPoints[i].x(), 2.0) + pow(arcIntersectedPoints[i].y(), 2.0));
-		angle = atan2(arcIntersectedPoints[i].y(), arcIntersectedPoints[i].x());
-		painter.drawLine(0, 0, radius*cos(angle), radius * sin(angle));
-	}
+	frame.freezeVolume = state.currentFreezeVolume;
+	frame.energyVolume = state.currentEnergyVolume;
 	circleMutex.unlock();
 
-#endif // QT_DEBUG
+	drawIndicators(*paintLevel, frame, width, height, painter);
 }
 
-void Game::drawUI(double width, double height, QPainter & painter)
+void Game::drawUI(const FrameState & frame, double width, double height, QPainter & painter)
 {
+	drawIndicators(*level, frame, width, height, painter);
+}
+
+void Game::drawIndicators(const GameLevel & paint, const FrameState & frame, double width, double height, QPainter & painter)
+{
+	const GameSettings &settings = paint.settings;
+	const GameResources &resources = paint.resources;
 	painter.setPen(*resources.circutPen);
 
-	circleMutex.lock();
-	double freezeVol = currentFreezeVolume;
-	double energyVol = currentEnergyVolume;
-	circleMutex.unlock();
+	double freezeVol = frame.freezeVolume;
+	double energyVol = frame.energyVolume;
 
 	painter.setBrush(*resources.energyBrush);
 
@@ -189,405 +232,617 @@ void GameEnvironment::Game::stopExecution()
 {
 	QMutexLocker locker(&inputMutex);
 	executing = false;
+	restartRequested = false;
+	notifyInput();
 }
 
-double Game::atan4(double y, double x)
+void Game::restart()
 {
-	double ang = atan2(y, x);
-	return ang > 0 ? ang : ang + 2 * M_PI;
+	QMutexLocker locker(&inputMutex);
+	executing = false;
+	restartRequested = true;
+	notifyInput();
 }
 
-void Game::run()
+void Game::restart(GameLevel * next)
 {
-	QTime timer;
-	double deltaTime = 0;
-	double mouseAngleDifference;
-	QRectF currentMouseRect;
+	if (deviceScale > 0)
+		next->renderCache->prepare(deviceScale, deviceHints);//draw takes it over from here
 
-	mouseRect.setRect(-INFINITY, -INFINITY, 0, 0);
-	lastMouseRect = mouseRect;
+	QMutexLocker locker(&inputMutex);
+	if (pendingLevel)
+	{
+		QMutexLocker commandsLocker(&commandsMutex);
+		retiredLevels.append(pendingLevel);
+	}
+	pendingLevel = next;
+	executing = false;
+	restartRequested = true;
+	notifyInput();
+}
 
-	leftMButtonPressed = false;
-	rightMButtonPressed = false;
+void Game::setRecordingInput(bool recording)
+{
+	QMutexLocker locker(&inputMutex);
+	recordingInput = recording;
+}
 
-	executing = true;
-	gameFinished = false;
+void Game::setStatePublisher(StatePublisher * publisher)
+{
+	QMutexLocker locker(&circleMutex);
+	statePublisher = publisher;
+}
 
-	for (int i = 0; i < gameCircle->count(); i++)
+void Game::setScheduling(const SchedulingOptions & options)
+{
+	QMutexLocker locker(&inputMutex);
+	scheduling = options;
+	schedulingChanged = true;
+	notifyInput();
+}
+
+void Game::setJitterProfiler(JitterProfiler * profiler)
+{
+	QMutexLocker locker(&inputMutex);
+	jitterProfiler = profiler;
+}
+
+void Game::setLatencyProbe(LatencyProbe * probe)
+{
+	QMutexLocker locker(&inputMutex);
+	QMutexLocker commandsLocker(&commandsMutex);
+	latencyProbe = probe;
+	pendingInput = -1;
+}
+
+void Game::setParallelIntegration(int threads, int threshold)
+{
+	ringIntegrator->setThreadCount(threads);
+	ringIntegrator->setParallelThreshold(threshold);
+}
+
+void Game::setBinaryAngles(bool binary)
+{
+	ringIntegrator->setBinaryArcs(binary ? gameCircle->ringList() : QVector<Ring>());
+}
+
+void Game::setLevel(GameLevel * next)
+{
+	GameLevel *previous = level;
+	level = next;
+	ringIntegrator->setBinaryArcs(level->settings.binaryAngles ? level->initialCircle->ringList() : QVector<Ring>());
+	ringIntegrator->setStaticIntegration(level->settings.staticIntegration ? level->settings.staticIntegration() : nullptr);
+
+	commandsMutex.lock();
+	retiredLevels.append(previous);
+	commandsMutex.unlock();
+}
+
+void Game::setDeviceScale(double scale, QPainter::RenderHints hints)
+{
+	if (scale == deviceScale && hints == deviceHints)
+		return;
+	deviceScale = scale;
+	deviceHints = hints;
+	if (scale > 0)
+		paintLevel->renderCache->prepare(scale, hints);
+}
+
+void Game::setDebugDrawing(bool enabled)
+{
+	debugDrawing = enabled;
+}
+
+InputRecording Game::inputRecording()
+{
+	QMutexLocker locker(&inputMutex);
+	return recordedInput;
+}
+
+void Game::applyInput(const InputEvent & event)
+{
+	switch (event.type)
 	{
-		gameCircle->addRingRotation(i, gameCircle->at(i).additionalRotation);
-		gameCircle->moveRing(i, 0);
-		gameCircle->setIsRingSelected(i, false);
-		gameCircle->setRingSelectionScore(i, 0);
-		gameCircle->setIsRingRotating(i, false);
+	case InputEvent::MouseMove:
+		setMouseRect(event.rect);
+		break;
+	case InputEvent::StartRingDragging:
+		startRingDragging();
+		break;
+	case InputEvent::StopRingDragging:
+		stopRingDragging();
+		break;
+	case InputEvent::Freeze:
+		freeze();
+		break;
+	case InputEvent::Unfreeze:
+		unfreeze();
+		break;
+	case InputEvent::Rewind:
+		rewind(event.seconds);
+		break;
+	case InputEvent::Tick:
+		break;//the caller ticks
 	}
+}
 
-	currentCoreWidthScore = 0;
-	currentEnergyVolume = settings.energyVolume;
-	currentFreezeVolume = settings.freezeVolume;
-
-	bool rotating = false;
-	bool frozen = false;
-	double fullRotation;
+double Game::nextTickTime()
+{
+	QMutexLocker locker(&inputMutex);
+	return nextEventTime;
+}
 
-	double xMin;
-	double yMin;
-	double xMax;
-	double yMax;
+FrameState Game::frameState()
+{
+	FrameState frame;
 
-	double xMinSqr;
-	double xMaxSqr;
-	double yMinSqr;
-	double yMaxSqr;
+	inputMutex.lock();
+	frame.mouseRect = mouseRect;
+	inputMutex.unlock();
 
-	double sqrExternalRadius;
-	double sqrInternalRadius;
+	QMutexLocker locker(&circleMutex);
+	for (int i = 0; i < gameCircle->count(); i++)
+		frame.rings.append(gameCircle->at(i));
+	frame.coreWidthScore = state.currentCoreWidthScore;
+	frame.gameWon = state.gameWon;
+	frame.energyVolume = state.currentEnergyVolume;
+	frame.freezeVolume = state.currentFreezeVolume;
+	return frame;
+}
 
-	double startAngle;
-	double endAngle;
+int Game::renderMemoryUsage() const
+{
+	return paintLevel->renderCache->memoryUsage();
+}
 
-	double pointAngle;
+const GameSettings & Game::getSettings() const
+{
+	return level->settings;
+}
 
-	bool emitted = false;
+double Game::atan4(double y, double x)
+{
+	double ang = atan2(y, x);
+	return ang > 0 ? ang : ang + 2 * M_PI;
+}
 
-	emit Start();
-	timer.start();
+void Game::startExecution(Priority priority)
+{
+	//set before the thread exists, so a stopExecution right after it is not overwritten
+	inputMutex.lock();
+	executing = true;
+	restartRequested = false;
+	inputMutex.unlock();
+	QThread::start(priority);
+}
 
+void Game::run()
+{
 	forever
 	{
+		reset();
 
+		emit Start();
+		commandsMutex.lock();
+		clock.start();
+		commandsMutex.unlock();
 
+		while (tick(getDeltaTime(clock)))
+		{
+#ifdef QT_DEBUG
+			if(!state.gameFinished)
+			std::cerr << state.currentEnergyVolume << std::endl;
+#endif
+			waitForInput();
+		}
 
-
-		deltaTime = getDeltaTime(timer);
 		inputMutex.lock();
-		if (executing == false)
+		if (!restartRequested)
 		{
 			inputMutex.unlock();
 			break;
 		}
+		restartRequested = false;
+		executing = true;
+		GameLevel *next = pendingLevel;
+		pendingLevel = nullptr;
+		inputMutex.unlock();
 
-		if (lastMouseRect != mouseRect)
-		{
-			mouseAngleDifference = atan4(lastMouseRect.y(), lastMouseRect.x()) - atan4(mouseRect.y(), mouseRect.x());
-			lastMouseRect = mouseRect;
-			currentMouseRect = mouseRect;
-		}
-		else
-			mouseAngleDifference = 0;
+		if (next)
+			setLevel(next);
+	}
+}
 
-		if (rotating != leftMButtonPressed)
-		{
-			energyStartTime = deltaTime;
-			lastEnergyVolume = currentEnergyVolume;
-		}
-		rotating = leftMButtonPressed;
+void Game::waitForInput()
+{
+	QMutexLocker locker(&inputMutex);
+	if (schedulingChanged)
+	{
+		scheduling.apply();
+		schedulingChanged = false;
+	}
 
-		if (frozen != rightMButtonPressed)
-		{
-			freezeStartTime = deltaTime;
-			lastFreezeVolume = currentFreezeVolume;
-		}
-		frozen = rightMButtonPressed;
+	double wait = nextEventTime - getDeltaTime(clock);
+	if (!inputChanged && executing && wait > 0)
+	{
+		ulong scheduled = ulong(ceil(wait));
+		QElapsedTimer timer;
+		timer.start();
+		//wake ups caused by input were not scheduled, they are not measured
+		if (!inputArrived.wait(&inputMutex, scheduled) && jitterProfiler)
+			jitterProfiler->record(timer.nsecsElapsed() / 1e6 - scheduled);
+	}
+	inputChanged = false;
+}
+
+void Game::notifyInput()
+{
+	inputChanged = true;
+	inputArrived.wakeAll();
+}
+
+void Game::reset()
+{
+	inputMutex.lock();
+	mouseRect.setRect(-INFINITY, -INFINITY, 0, 0);
+	lastMouseRect = mouseRect;
+	leftMButtonPressed = false;
+	rightMButtonPressed = false;
+	recordedInput.clear();
+	rewindSeconds = 0;
+	placeCursor = true;
+	pendingInput = -1;
+	inputMutex.unlock();
+
+	currentMouseRect = QRectF();
+
+	circleMutex.lock();
+	*gameCircle = *level->initialCircle;
+	state = level->initialState;
+	history.clear();
+	timeOffset = 0;
+	circleMutex.unlock();
+
+	publishCommands();
+}
+
+bool Game::tick(double time)
+{
+	const GameSettings &settings = level->settings;
+	double mouseAngleDifference;
+
+	inputMutex.lock();
+	if (executing == false)
+	{
 		inputMutex.unlock();
+		return false;
+	}
+	double rewindTo = time - timeOffset - rewindSeconds * 1000;
+	bool rewinding = rewindSeconds > 0;
+	rewindSeconds = 0;
 
-		if (!gameFinished)
+	//every input this tick takes is read in this one section, so the Tick marker follows exactly the events it took
+	if (recordingInput)
+		recordedInput.append(InputEvent(qRound(time), InputEvent::Tick));//replays tick exactly here, not at a schedule of their own
+
+	if (lastMouseRect != mouseRect)
+	{
+		mouseAngleDifference = atan4(lastMouseRect.y(), lastMouseRect.x()) - atan4(mouseRect.y(), mouseRect.x());
+		lastMouseRect = mouseRect;
+		currentMouseRect = mouseRect;
+		placeCursor = true;
+	}
+	else
+		mouseAngleDifference = 0;
+
+	LatencyStamp latency;
+	if (pendingInput >= 0)
+	{
+		latency.input = pendingInput;
+		latency.picked = latencyProbe->now();
+		pendingInput = -1;
+	}
+
+	if (placeCursor && !cursorShape.isEmpty())
+		cursorShape.place(currentMouseRect, cursorPolygon);
+	placeCursor = false;
+	bool polygonCursor = !cursorShape.isEmpty();
+	bool rotating = leftMButtonPressed;
+	bool frozen = rightMButtonPressed;
+	inputMutex.unlock();
+
+	if (rewinding && history.count() > 0)
+	{
+		QMutexLocker locker(&circleMutex);
+		int index = history.indexAt(rewindTo);
+		timeOffset = time - history.timeAt(index);
+		QVector<Ring> rings = gameCircle->ringList();
+		history.restore(index, state, rings);
+		gameCircle->setRingList(rings);
+	}
+	double deltaTime = time - timeOffset;
+	double horizon = snapshotInterval;//ms until something can change without input
+
+	if (state.rotating != rotating)
+	{
+		state.energyStartTime = deltaTime;
+		state.lastEnergyVolume = state.currentEnergyVolume;
+	}
+	state.rotating = rotating;
+
+	if (state.frozen != frozen)
+	{
+		state.freezeStartTime = deltaTime;
+		state.lastFreezeVolume = state.currentFreezeVolume;
+	}
+	state.frozen = frozen;
+
+	if (!state.gameFinished)
+	{
+		circleMutex.lock();
+		if (state.rotating)
 		{
-			circleMutex.lock();
-			if (rotating)
+			if (state.currentEnergyVolume >= 0)
+				state.currentEnergyVolume = state.lastEnergyVolume - (deltaTime - state.energyStartTime) / double(1000);
+			else
 			{
-				if (currentEnergyVolume >= 0)
-					currentEnergyVolume = lastEnergyVolume - (deltaTime - energyStartTime) / double(1000);
-				else
-				{
-					leftMButtonPressed = false;
-					currentEnergyVolume = 0;
-				}
+				leftMButtonPressed = false;
+				state.currentEnergyVolume = 0;
 			}
-			else
+		}
+		else
+		{
+			if (state.currentEnergyVolume < settings.energyVolume)
 			{
-				if (currentEnergyVolume < settings.energyVolume)
-				{
-					currentEnergyVolume = lastEnergyVolume + settings.energyRegenirationSpeed *(deltaTime - energyStartTime) / double(1000);
-				}
-				else if (currentEnergyVolume != settings.energyVolume)
-				{
-					currentEnergyVolume = settings.energyVolume;
-				}
+				state.currentEnergyVolume = state.lastEnergyVolume + settings.energyRegenirationSpeed *(deltaTime - state.energyStartTime) / double(1000);
 			}
-
-			if (frozen)
+			else if (state.currentEnergyVolume != settings.energyVolume)
 			{
-				if (currentFreezeVolume >= 0)
-					currentFreezeVolume = lastFreezeVolume - (deltaTime - freezeStartTime) / double(1000);
-				else
-				{
-					rightMButtonPressed = false;
-					currentFreezeVolume = 0;
-				}
+				state.currentEnergyVolume = settings.energyVolume;
 			}
+		}
+
+		if (state.frozen)
+		{
+			if (state.currentFreezeVolume >= 0)
+				state.currentFreezeVolume = state.lastFreezeVolume - (deltaTime - state.freezeStartTime) / double(1000);
 			else
 			{
-				if (currentFreezeVolume < settings.freezeVolume)
-				{
-					currentFreezeVolume = lastFreezeVolume + settings.freezeRegenirationSpeed *(deltaTime - freezeStartTime) / double(1000);
-				}
-				else if (currentFreezeVolume != settings.freezeVolume)
-				{
-					currentFreezeVolume = settings.freezeVolume;
-				}
+				rightMButtonPressed = false;
+				state.currentFreezeVolume = 0;
 			}
-			circleMutex.unlock();
 		}
-
-		if (gameFinished)
+		else
 		{
-			QMutexLocker locker(&circleMutex);
-			if ((currentCoreWidthScore > -1 & !gameWon) ||
-				(currentCoreWidthScore < 1 & gameWon))
+			if (state.currentFreezeVolume < settings.freezeVolume)
 			{
-				currentCoreWidthScore = (gameWon ? settings.goodSpreadingSpeed : settings.goodClearingSpeed) * (deltaTime - gameFinishedTime) / 1000.0;
+				state.currentFreezeVolume = state.lastFreezeVolume + settings.freezeRegenirationSpeed *(deltaTime - state.freezeStartTime) / double(1000);
 			}
-			else if(!emitted)
+			else if (state.currentFreezeVolume != settings.freezeVolume)
 			{
-				emit gameWon ? GameWon() : GameOver();
-				emitted = true;
-				//break;
+				state.currentFreezeVolume = settings.freezeVolume;
 			}
 		}
+		circleMutex.unlock();
 
-		for (int i = 0; i < gameCircle->count(); i++)
+		//depletion and full regeneration
+		if (state.rotating)
+			horizon = qMin(horizon, state.currentEnergyVolume * 1000);
+		else if (state.currentEnergyVolume < settings.energyVolume)
+			horizon = qMin(horizon, (settings.energyVolume - state.currentEnergyVolume) / settings.energyRegenirationSpeed * 1000);
+		if (state.frozen)
+			horizon = qMin(horizon, state.currentFreezeVolume * 1000);
+		else if (state.currentFreezeVolume < settings.freezeVolume)
+			horizon = qMin(horizon, (settings.freezeVolume - state.currentFreezeVolume) / settings.freezeRegenirationSpeed * 1000);
+	}
+
+	if (state.gameFinished)
+	{
+		QMutexLocker locker(&circleMutex);
+		if ((state.currentCoreWidthScore > -1 & !state.gameWon) ||
+			(state.currentCoreWidthScore < 1 & state.gameWon))
 		{
-			circleMutex.lock();
-			deltaTime = getDeltaTime(timer);
-			Ring ring = gameCircle->at(i);
-			circleMutex.unlock();
-			if (i != 0)
-			{
-				circleMutex.lock();
-				if (ring.isRotating || (frozen && !gameFinished))
-					gameCircle->addRingRotation(i, ring.rotation - ring.angleSpeed * deltaTime / double(1000));
-				gameCircle->moveRing(i, ring.angleSpeed * deltaTime / double(1000));
-				ring = gameCircle->at(i);
-				circleMutex.unlock();
-				fullRotation = ring.additionalRotation + ring.rotation;
-
-				if (ring.isRotating && !rotating)
-				{
-					circleMutex.lock();
-					gameCircle->setIsRingRotating(i, false);
-					circleMutex.unlock();
-					ring.isRotating = false;
-				}
-			}
+			state.currentCoreWidthScore = (state.gameWon ? settings.goodSpreadingSpeed : settings.goodClearingSpeed) * (deltaTime - state.gameFinishedTime) / 1000.0;
+		}
+		else if(!state.finishEmitted)
+		{
+			emit state.gameWon ? GameWon(time) : GameOver(time);
+			state.finishEmitted = true;
+			//break;
+		}
 
-			xMin = currentMouseRect.x();
-			yMin = currentMouseRect.y();
-			xMax = xMin + currentMouseRect.width();
-			yMax = yMin + currentMouseRect.height();
+		if (!state.finishEmitted)
+		{
+			double speed = state.gameWon ? settings.goodSpreadingSpeed : settings.goodClearingSpeed;
+			horizon = qMin(horizon, ((state.gameWon ? 1 : -1) - state.currentCoreWidthScore) / speed * 1000);
+		}
+	}
 
-			sqrExternalRadius = pow(ring.internalRadius + ring.width,2.0);
-			sqrInternalRadius = pow(ring.internalRadius,2.0);
+	RingStep step;
+	step.deltaTime = deltaTime;
+	step.mouseAngleDifference = mouseAngleDifference;
+	step.selectingSpeed = settings.ringSelectingSpeed;
+	step.rotating = state.rotating;
+	step.frozen = state.frozen;
+	step.finished = state.gameFinished;
+	step.mouseRect = currentMouseRect;
+	step.polygon = polygonCursor ? &cursorPolygon : nullptr;
+	int finisher = ringIntegrator->integrate(gameCircle->ringList(), integratedRings, step, horizon);
 
-			xMinSqr = xMin < 0 && xMax > 0 ? 0 : pow(qMin(abs(xMin), abs(xMax)), 2.0);
-			xMaxSqr = pow(xMinSqr == 0? xMax : qMax(abs(xMin), abs(xMax)),2.0);
-			yMinSqr = yMin < 0 && yMax > 0 ? 0 : pow(qMin(abs(yMin), abs(yMax)), 2.0);
-			yMaxSqr = pow(yMinSqr == 0? yMax : qMax(abs(yMin), abs(yMax)), 2.0);
+	circleMutex.lock();
+	gameCircle->swapRingList(integratedRings);
+	if (finisher >= 0)//readers see the rings and the outcome of the same tick
+	{
+		state.gameFinished = true;
+		state.gameWon = finisher == 0;
+		state.gameFinishedTime = deltaTime;
+	}
+	circleMutex.unlock();
 
-			
-			if (xMinSqr + yMinSqr <= sqrExternalRadius && xMaxSqr + yMaxSqr >= sqrInternalRadius && !gameFinished)
-			{
-				if (i == 0)
-				{
-					gameFinished = true;
-					gameWon = true;
-					gameFinishedTime = deltaTime;
-					continue;
-				}
-
-
-				circleMutex.lock();
-				arcIntersectedPoints.clear();
-				addPointIfInsideIntersectedArea(xMin, yMin, sqrInternalRadius, sqrExternalRadius, arcIntersectedPoints);
-				addPointIfInsideIntersectedArea(xMin, yMax, sqrInternalRadius, sqrExternalRadius, arcIntersectedPoints);
-				addPointIfInsideIntersectedArea(xMax, yMin, sqrInternalRadius, sqrExternalRadius, arcIntersectedPoints);
-				addPointIfInsideIntersectedArea(xMax, yMax, sqrInternalRadius, sqrExternalRadius, arcIntersectedPoints);
-
-				find_and_add_pointsThatIntersectsRadiusInArea_X(xMin, yMin, yMax, sqrExternalRadius, arcIntersectedPoints);
-				find_and_add_pointsThatIntersectsRadiusInArea_X(xMax, yMin, yMax, sqrExternalRadius, arcIntersectedPoints);
-				find_and_add_pointsThatIntersectsRadiusInArea_X(xMin, yMin, yMax, sqrInternalRadius, arcIntersectedPoints);
-				find_and_add_pointsThatIntersectsRadiusInArea_X(xMax, yMin, yMax, sqrInternalRadius, arcIntersectedPoints);
-
-				find_and_add_pointsThatIntersectsRadiusInArea_Y(yMin, xMin, xMax, sqrExternalRadius, arcIntersectedPoints);
-				find_and_add_pointsThatIntersectsRadiusInArea_Y(yMax, xMin, xMax, sqrExternalRadius, arcIntersectedPoints);
-				find_and_add_pointsThatIntersectsRadiusInArea_Y(yMin, xMin, xMax, sqrInternalRadius, arcIntersectedPoints);
-				find_and_add_pointsThatIntersectsRadiusInArea_Y(yMax, xMin, xMax, sqrInternalRadius, arcIntersectedPoints);
-				circleMutex.unlock();
-
-				for (int j = 0; j < ring.arcs.count(); j++)
-				{
-					Arc arc = ring.arcs[j];
-					startAngle = Circle::adjustAngle(fullRotation + arc.position * 2.0 * M_PI);
-					if (startAngle < 0)
-						startAngle += 2.0 * M_PI;
-					endAngle = Circle::adjustAngle(fullRotation + (arc.position + arc.length)* 2.0 * M_PI);
-					if (endAngle < 0)
-						endAngle += 2.0 * M_PI;
-
-					circleMutex.lock();
-					for (int k = 0; k < arcIntersectedPoints.count(); k++)
-					{
-						pointAngle = atan4(-arcIntersectedPoints[k].y(), arcIntersectedPoints[k].x());
-						if (startAngle < endAngle)
-						{
-							if (pointAngle > startAngle & pointAngle < endAngle)
-							{
-								gameFinished = true;
-								gameWon = false;
-								gameFinishedTime = deltaTime;
-								continue;
-							}
-						}
-						else
-						{
-							if ((pointAngle > startAngle) || (pointAngle > 0 & pointAngle < endAngle))
-							{
-								gameFinished = true;
-								gameWon = false;
-								gameFinishedTime = deltaTime;
-								continue;
-							}
-						}
-					}
-					circleMutex.unlock();
-
-				}
-
-				if (!ring.isRotating && rotating)
-				{
-					circleMutex.lock();
-					gameCircle->setIsRingRotating(i, true);
-					circleMutex.unlock();
-					ring.isRotating = true;
-				}
-
-				if (ring.isRotating)
-				{
-					circleMutex.lock();
-					gameCircle->addRingRotation(i, mouseAngleDifference);
-					circleMutex.unlock();
-				}
-
-				if (!ring.isSelected)
-				{
-					circleMutex.lock();
-					gameCircle->setIsRingSelected(i, true);
-					gameCircle->setRingSelectionStartDeltaTime(i, deltaTime);
-					ring = gameCircle->at(i);
-					circleMutex.unlock();
-				}
-
-				if (ring.selectedScore < 1)
-				{
-					QMutexLocker locker(&circleMutex);
-					gameCircle->setRingSelectionScore(i, qMin(ring.lastSelectionScore + settings.ringSelectingSpeed * (deltaTime - ring.selectionStartTime) / double(1000), 1.0));
-				}
-			}
-			else
-			{
-				if (ring.isRotating)
-				{
-					circleMutex.lock();
-					gameCircle->setIsRingRotating(i, false);
-					circleMutex.unlock();
-					ring.isRotating = false;
-				}
-				if (ring.isSelected)
-				{
-					circleMutex.lock();
-					gameCircle->setIsRingSelected(i, false);
-					gameCircle->setRingSelectionStartDeltaTime(i, deltaTime);
-					ring = gameCircle->at(i);
-					circleMutex.unlock();
-				}
-
-				if (ring.selectedScore > 0)
-				{
-					QMutexLocker locker(&circleMutex);
-					gameCircle->setRingSelectionScore(i, qMax(ring.lastSelectionScore - settings.ringSelectingSpeed * (deltaTime - ring.selectionStartTime) / double(1000), 0.0));
-				}
-			}
+	if (!state.gameFinished && (history.count() == 0 || deltaTime - history.timeAt(history.count() - 1) >= snapshotInterval))
+	{
+		QMutexLocker locker(&circleMutex);
+		history.push(deltaTime, state, gameCircle->ringList());
+	}
+
+	circleMutex.lock();
+	if (statePublisher)
+		statePublisher->publish(deltaTime, state, gameCircle->ringList(), currentMouseRect);
+	circleMutex.unlock();
+
+	RenderMotion motion;
+	motion.time = time;
+	motion.frozen = state.frozen && !state.gameFinished;
+	motion.selectingSpeed = settings.ringSelectingSpeed / 1000;
+	if (state.gameFinished && !state.finishEmitted)
+		motion.coreSpeed = (state.gameWon ? settings.goodSpreadingSpeed : settings.goodClearingSpeed) / 1000;
+	publishCommands(motion, latency);
+
+	inputMutex.lock();
+	nextEventTime = time + qMax(horizon, 1.0);
+	inputMutex.unlock();
+	return true;
+}
+
+void Game::publishCommands(const RenderMotion &motion, const LatencyStamp &latency)
+{
+	circleMutex.lock();
+	backCommands.build(gameCircle->ringList(), state.currentCoreWidthScore, state.gameWon, motion);
+	circleMutex.unlock();
+	backCommands.level = level;
+
+	commandsMutex.lock();
+	backCommands.latency = latency;
+	if (readyCommands.latency.input >= 0)
+		backCommands.latency = readyCommands.latency;//an older input still waits for a draw
+	else if (latency.input >= 0 && latencyProbe)
+		backCommands.latency.published = latencyProbe->now();
+	readyCommands.swap(backCommands);
+	readyPublished = true;
+
+	QVector<GameLevel*> released;
+	for (int i = retiredLevels.count() - 1; i >= 0; i--)
+	{
+		if (retiredLevels[i] != paintLevel && retiredLevels[i] != readyCommands.level)
+		{
+			released.append(retiredLevels[i]);
+			retiredLevels.remove(i);
 		}
-		if(!gameFinished)
-		std::cerr << currentEnergyVolume << std::endl;
 	}
+	commandsMutex.unlock();
+
+	qDeleteAll(released);
 }
 
 
 
-int Game::getDeltaTime(QTime & timer)
+void Game::record(InputEvent::Type type, QRectF rect, double seconds)
 {
-	return timer.elapsed();
+	//every kind of input passes here
+	if (latencyProbe && pendingInput < 0)
+		pendingInput = latencyProbe->now();
+	if (recordingInput)
+		recordedInput.append(InputEvent(clock.elapsed(), type, rect, seconds));
 }
 
-void Game::addPointIfInsideIntersectedArea(double x, double y, double sqrInternalRadius, double sqrExternalRadius, QVector<QPointF> &arcIntersectedPoints)
+int Game::getDeltaTime(QTime & timer)
 {
-	double sumOfSqr = pow(x, 2.0) + pow(y, 2.0);
-	if (sumOfSqr <= sqrExternalRadius && sumOfSqr >= sqrInternalRadius)
-		arcIntersectedPoints.append(QPointF(x, y));
+	return timer.elapsed();
 }
 
-void Game::find_and_add_pointsThatIntersectsRadiusInArea_X(double x, double yMin, double yMax, double sqrRadius, QVector<QPointF>& arcIntersectedPoints)
+void Game::replay(const RenderCommandList & commands, double elapsed, double cornerDist, QPainter & painter)
 {
-	double absY = sqrRadius - pow(x, 2.0);
+	QBrush background = painter.background();
+	int currentBrush = -1;
+	int currentAlpha = -1;
 
-	if (absY >= 0)
+	for (int i = 0; i < commands.count(); i++)
 	{
-		absY = sqrt(absY);
-		if (yMax >= absY && yMin <= absY)
-			arcIntersectedPoints.append(QPointF(x, absY));
-		absY = -absY;
-		if (yMax >= absY && yMin <= absY)
-			arcIntersectedPoints.append(QPointF(x, absY));
+		const RenderCommand &command = commands[i];
+		int alpha = command.brush == RenderCommandList::SelectionBrush ? RenderCache::alphaLevel(command.alpha + command.alphaSpeed * elapsed) : 0;
+		if (command.brush != currentBrush || (command.brush == RenderCommandList::SelectionBrush && alpha != currentAlpha))
+		{
+			if (command.brush == RenderCommandList::BackgroundBrush)
+				painter.setBrush(background);
+			else if (command.brush == RenderCommandList::SelectionBrush)
+			{
+				painter.setBrush(commands.level->renderCache->selectionBrush(alpha));
+				currentAlpha = alpha;
+			}
+			else
+				painter.setBrush(*commands.level->resources.ringBrushes[command.brush - RenderCommandList::FirstRingBrush]);
+			currentBrush = command.brush;
+		}
+
+		int radius = command.radius;
+		if (command.type == RenderCommand::Pie)
+			painter.drawPie(-radius, -radius, radius * 2, radius * 2, command.startAngle + qRound(command.angleSpeed * elapsed), command.spanAngle);
+		else
+			painter.drawEllipse(-radius, -radius, radius * 2, radius * 2);
 	}
+	drawCore(commands, elapsed, cornerDist, painter);
 }
 
-void Game::find_and_add_pointsThatIntersectsRadiusInArea_Y(double y, double xMin, double xMax, double sqrRadius, QVector<QPointF>& arcIntersectedPoints)
+void Game::drawCore(const RenderCommandList & commands, double elapsed, double cornerDist, QPainter & painter)
 {
+	double coreWidthScore = commands.coreWidthScore + commands.motion.coreSpeed * elapsed;
+	if (commands.motion.coreSpeed != 0)
+		coreWidthScore = qBound(qMin(-1.0, commands.coreWidthScore), coreWidthScore, qMax(1.0, commands.coreWidthScore));
 
-	double absX = sqrRadius - pow(y, 2.0);
+	int radius = commands.coreRadius;
+	int exRadius = radius + coreWidthScore * (commands.gameWon? cornerDist / 0.3 : radius);
 
-	if (absX >= 0)
+	if (exRadius == radius)
 	{
-		absX = sqrt(absX);
-		if (xMax >= absX && xMin <= absX)
-			arcIntersectedPoints.append(QPointF(absX, y));
-		absX = -absX;
-		if (xMax >= absX && xMin <= absX)
-			arcIntersectedPoints.append(QPointF(absX, y));
+		double scale = deviceScale > 0 ? deviceScale : RenderCache::deviceScale(painter);
+		const QImage &sprite = commands.level->renderCache->coreSprite(radius, scale, painter.renderHints());
+		painter.drawImage(QRectF(-radius, -radius, radius * 2, radius * 2), sprite);
+	}
+	else
+	{
+		exRadius *= goodColorBefore;
+		
+		painter.setBrush(*commands.level->resources.goodBrush);
+		painter.drawEllipse(-exRadius, -exRadius, exRadius * 2, exRadius * 2);
 	}
 }
 
-void Game::drawCore(double cornerDist, QPainter & painter)
+#ifdef QT_DEBUG
+void Game::drawDebug(const FrameState & frame, QPainter & painter)
 {
-	circleMutex.lock();
-	int radius = gameCircle->at(0).width;
-	int exRadius = radius + currentCoreWidthScore * (gameWon? cornerDist / 0.3 : radius);
-	circleMutex.unlock();
+	painter.save();
+	painter.setPen(QColor(Qt::yellow));
+	painter.setBrush(Qt::BrushStyle::NoBrush);
 
-	if (exRadius == radius)
+	for (int i = 1; i < frame.rings.count(); i++)
 	{
-		painter.setBrush(*resources.fromGoodToEvilGradient);
-		painter.drawEllipse(-radius, -radius, radius * 2, radius * 2);
+		const Ring &ring = frame.rings[i];
+		double ringRotation = ring.rotation + ring.additionalRotation;
+		for (int j = 0; j < ring.arcs.length(); j++)
+		{
+			double s_ang = ringRotation + ring.arcs[j].position * M_PI * 2;
+			double e_ang = s_ang + ring.arcs[j].length * 2.0 *M_PI;
+
+			painter.drawLine(0, 0, 250.0 * cos(s_ang), 250.0 * -sin(s_ang));
+			painter.drawLine(0, 0, 250.0 * cos(e_ang), 250.0 * -sin(e_ang));
+		}
 	}
-	else
+
+	painter.drawRect(frame.mouseRect);
+
+	//the points the last tick tested the arcs with
+	painter.setPen(QColor(Qt::red));
+	QVector<QPointF> points;
+	for (int i = 1; i < frame.rings.count(); i++)
 	{
-		exRadius *= goodColorBefore;
-		
-		painter.setBrush(*resources.goodBrush);
-		painter.drawEllipse(-exRadius, -exRadius, exRadius * 2, exRadius * 2);
+		const Ring &ring = frame.rings[i];
+		Collision::intersectionPoints(frame.mouseRect, pow(ring.internalRadius, 2.0), pow(ring.internalRadius + ring.width, 2.0), points);
 	}
+	for (int i = 0; i < points.count(); i++)
+		painter.drawLine(0, 0, points[i].x(), points[i].y());
+	painter.restore();
 }
+#endif // QT_DEBUG
 
 Circle::Circle(double coreWidth)
 {
@@ -638,6 +893,21 @@ Ring Circle::operator[](int i) const
 	return rings[i];
 }
 
+const QVector<Ring> &Circle::ringList() const
+{
+	return rings;
+}
+
+void Circle::setRingList(const QVector<Ring> &ringList)
+{
+	rings = ringList;
+}
+
+void Circle::swapRingList(QVector<Ring> &ringList)
+{
+	rings.swap(ringList);
+}
+
 Ring Circle::at(int i) const
 {
 	return rings.at(i);
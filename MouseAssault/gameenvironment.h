@@ -9,6 +9,10 @@
 #include <QReadWriteLock>
 #include <QPainter>
 #include <QWaitCondition>
+#include "rendercommands.h"
+#include "snapshothistory.h"
+#include "cursorshape.h"
+#include "scheduling.h"
 
 namespace GameEnvironment
 {
@@ -17,6 +21,12 @@ namespace GameEnvironment
 	class Circle;
 	struct Ring;
 	struct Arc;
+	class StatePublisher;
+	class JitterProfiler;
+	class LatencyProbe;
+	class RingIntegrator;
+	class StaticRingIntegration;
+	class RenderCache;
 
 	struct GameSettings
 	{
@@ -37,6 +47,8 @@ namespace GameEnvironment
 		double energyVolume;//in secs
 		double freezeVolume;
 
+		bool binaryAngles = false;//arcs are converted to binary angles at load and hit tested with integer math
+		StaticRingIntegration *(*staticIntegration)() = nullptr;//built-in levels declared as a StaticLevel table create their fixed size update with it
 	};
 
 	struct GameResources
@@ -50,70 +62,194 @@ namespace GameEnvironment
 		QBrush* freezeBrush;
 	};
 
+	struct FrameState
+	{
+		QVector<Ring> rings;//rings[0] is the core
+		double coreWidthScore;
+		bool gameWon;
+		double energyVolume;
+		double freezeVolume;
+		QRectF mouseRect;
+	};
+
+	//Everything the simulation changes between ticks apart from the rings,
+	//kept trivially copyable so a restart is a single assignment
+	struct SimulationState
+	{
+		double currentCoreWidthScore = 0;
+
+		double currentEnergyVolume = 0;
+		double energyStartTime = 0;
+		double lastEnergyVolume = 0;
+
+		double currentFreezeVolume = 0;
+		double freezeStartTime = 0;
+		double lastFreezeVolume = 0;
+
+		double gameFinishedTime = 0;
+		bool gameFinished = false;
+		bool gameWon = false;
+		bool finishEmitted = false;
+
+		bool rotating = false;
+		bool frozen = false;
+	};
+
+	struct InputEvent
+	{
+		enum Type { MouseMove, StartRingDragging, StopRingDragging, Freeze, Unfreeze, Rewind, Tick };//Tick is a tick of the live game, it took the events recorded before it
+
+		//a constructor instead of member initializers, MSVC 2015 does not brace initialize aggregates that have them
+		InputEvent(int time = 0, Type type = MouseMove, QRectF rect = QRectF(), double seconds = 0)
+			: time(time), type(type), rect(rect), seconds(seconds) {}
+
+		int time;//ms since the game started
+		Type type;
+		QRectF rect;//only for MouseMove
+		double seconds;//only for Rewind
+	};
+
+	typedef QVector<InputEvent> InputRecording;
+
+	//What a level needs before its first round: the settings, the paint resources and the initial rings.
+	//Built on any thread and not changed by the simulation afterwards, so a loader can prepare it while
+	//another level is played
+	class GameLevel
+	{
+	public:
+		GameLevel(const GameSettings &settings);
+		~GameLevel();
+
+		GameSettings settings;
+		GameResources resources;
+		Circle *initialCircle;
+		SimulationState initialState;//restored by reset together with initialCircle
+		RenderCache *renderCache;//selection brushes and core sprites for replay, only the drawing thread may use it
+	};
+
 	class Game : public QThread
 	{
 		Q_OBJECT
 	public:
 		Game(GameSettings s);
+		Game(GameLevel *first);//takes the level
 		~Game();
 		void setMouseRect(QRectF rect);
+		void setCursorShape(const CursorShape &shape);//an empty shape tests the mouse rect itself
 		void startRingDragging();
 		void stopRingDragging();
 		void freeze();
 		void unfreeze();
+		void rewind(double seconds);//applied by the next tick, goes back at most as far as the snapshot history
 		void draw(double cornerDist, QPainter &painter);
 		void drawUI(double width, double height, QPainter &painter);
-		void stopExecution();
+		void draw(const FrameState &frame, double cornerDist, QPainter &painter);//with the current level, for headless use
+		void drawUI(const FrameState &frame, double width, double height, QPainter &painter);
+		void startExecution(Priority priority = QThread::InheritPriority);//marks the game executing before the thread runs, QThread::start only works for the first start
+		void stopExecution();//ends the thread
+		void restart();//starts over on the running thread, Start is emitted again
+		void restart(GameLevel *next);//takes the level and starts over with it, the old one is deleted by the simulation thread once draw let go of it. Call from the thread that draws, its sprites are prepared here
+		void setRecordingInput(bool recording);
+		void setStatePublisher(StatePublisher *publisher);//not owned, nullptr stops publishing
+		void setScheduling(const SchedulingOptions &options);//applied by the simulation thread before its next wait
+		void setJitterProfiler(JitterProfiler *profiler);//not owned, gets how late every scheduled wake up was
+		void setLatencyProbe(LatencyProbe *probe);//not owned, input events are followed until draw shows them
+		void setParallelIntegration(int threads, int threshold);//levels with threshold rings or more update them on threads, never call while the thread is running
+		void setBinaryAngles(bool binary);//overrides GameSettings::binaryAngles, never call while the thread is running
+		void setDeviceScale(double scale, QPainter::RenderHints hints = QPainter::Antialiasing);//device pixels per unit of draw and the hints of the painter draw gets, the sprites are rendered here. 0 measures it from the painter. Only from the thread that draws
+		void setDebugDrawing(bool enabled);//debug builds draw collision helpers over draw, on by default. Only from the thread that draws
+		InputRecording inputRecording();
+
+		//manual stepping for headless use, never call while the thread is running
+		void reset();
+		bool tick(double time);//time in ms since reset, false once execution was stopped
+		void applyInput(const InputEvent &event);//taken by the next tick
+		double nextTickTime();//when run would tick again if no input arrived
+		FrameState frameState();
+		int renderMemoryUsage() const;//bytes held by the paint resources of the drawn level, only from the thread that draws
+		const GameSettings &getSettings() const;
 
 		static double atan4(double y, double x);
+
+		static constexpr double goodColorBefore = 0.3;
+		static constexpr double evilColorAt = 0.6;
 	signals:
 		void Start();
-		void GameWon();
-		void GameOver();
+		void GameWon(double time);//of the tick that finished the round
+		void GameOver(double time);
 	protected:
 		void run();
 	private:
 		int getDeltaTime(QTime &timer);
-		void addPointIfInsideIntersectedArea(double x, double y, double sqrInternalRadius, double sqrExternalRadius, QVector<QPointF> &arcIntersectedPoints);
-		void find_and_add_pointsThatIntersectsRadiusInArea_X(double x, double yMin, double yMax, double sqrRadius, QVector<QPointF> &arcIntersectedPoints);
-		void find_and_add_pointsThatIntersectsRadiusInArea_Y(double y, double xMin, double xMax, double sqrRadius, QVector<QPointF> &arcIntersectedPoints);
-		void drawCore(double cornerDist, QPainter &painter);
+		void replay(const RenderCommandList &commands, double elapsed, double cornerDist, QPainter &painter);//elapsed ms since the commands were built
+		void drawCore(const RenderCommandList &commands, double elapsed, double cornerDist, QPainter &painter);
+		void drawIndicators(const GameLevel &paint, const FrameState &frame, double width, double height, QPainter &painter);
+		void setLevel(GameLevel *next);//simulation thread only
+#ifdef QT_DEBUG
+		void drawDebug(const FrameState &frame, QPainter &painter);
+#endif
+		void publishCommands(const RenderMotion &motion = RenderMotion(), const LatencyStamp &latency = LatencyStamp());
+		void waitForInput();//sleeps until input arrives or nextEventTime
+		void notifyInput();//inputMutex must be held
+		void record(InputEvent::Type type, QRectF rect = QRectF(), double seconds = 0);//also stamps the event for the latency probe, inputMutex must be held
 
-		GameSettings settings;
-		GameResources resources;
+		GameLevel *level;//played by the simulation
+		GameLevel *paintLevel;//the level of frontCommands, replaced by draw under commandsMutex
+		GameLevel *pendingLevel = nullptr;//taken by the next restart, guarded by inputMutex
+		QVector<GameLevel*> retiredLevels;//deleted by the simulation thread when neither draw nor readyCommands uses them, guarded by commandsMutex
 
 		Circle *gameCircle;
+		QTime clock;
 		QRectF lastMouseRect;
 		QRectF mouseRect;
+		QRectF currentMouseRect;
+		CursorShape cursorShape;
+		CursorPolygon cursorPolygon;//cursorShape placed at currentMouseRect
+		bool placeCursor = true;//cursorPolygon is out of date
 		QMutex circleMutex;
 		QMutex inputMutex;
-		QVector<QPointF> arcIntersectedPoints;
+		QMutex commandsMutex;
+		RenderCommandList frontCommands;//replayed by draw, only the drawing thread touches it
+		RenderCommandList readyCommands;//the newest published list, swapped under commandsMutex
+		RenderCommandList backCommands;//built by the simulation
+		bool readyPublished = false;//readyCommands is newer than frontCommands
+		RingIntegrator *ringIntegrator;
+		double deviceScale = 0;//set by the window after resizes, sprites of other scales age out of the cache
+		QPainter::RenderHints deviceHints = QPainter::Antialiasing;
+		bool debugDrawing = true;
+		QVector<Ring> integratedRings;//the rings before the last tick, reused as the target of the next one
 
-		double currentCoreWidthScore = 0;
-
-		const double goodColorBefore = 0.3;
-		const double evilColorAt = 0.6;
 
 		const int indicatorsMargin = 5;
 		const int indicatorsDiameter = 45;
 		const double indicatorsStartQuarter = 1;
 
-		double currentEnergyVolume;
-		double energyStartTime;
-		double lastEnergyVolume;
-
-		double currentFreezeVolume;
-		double freezeStartTime;
-		double lastFreezeVolume;
-
 		bool leftMButtonPressed = false;
 		bool rightMButtonPressed = false;
 
-		double gameFinishedTime;
-		bool gameFinished = false;
-		bool gameWon = false;
+		SimulationState state;
+
+		SnapshotHistory history;
+		const int snapshotInterval = 50;//ms
+		double timeOffset = 0;//time lost to rewinding, tick subtracts it from the time it is given
+		double rewindSeconds = 0;
+
+		double nextEventTime = 0;//tick time at which the state changes next without input
+		SchedulingOptions scheduling;
+		bool schedulingChanged = false;
+		JitterProfiler *jitterProfiler = nullptr;
+		LatencyProbe *latencyProbe = nullptr;
+		qint64 pendingInput = -1;//when the oldest input event no tick has taken arrived
+		bool inputChanged = false;
+		QWaitCondition inputArrived;
 
 		bool executing = true;
+		bool restartRequested = false;
+
+		StatePublisher *statePublisher = nullptr;
+
+		bool recordingInput = false;
+		InputRecording recordedInput;
 	};
 
 	class Circle
@@ -129,6 +265,9 @@ namespace GameEnvironment
 		void setIsRingRotating(int index, bool isRotating);
 		Ring operator[](int i) const;
 		Ring at(int i) const;
+		const QVector<Ring> &ringList() const;
+		void setRingList(const QVector<Ring> &ringList);//same rings in another state
+		void swapRingList(QVector<Ring> &ringList);
 		int count();
 		int totalRadius() const;
 
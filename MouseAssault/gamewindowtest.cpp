@@ -1,104 +1,152 @@
 #include "gamewindowtest.h"
+#include "gamedata.h"
+#include "statepublisher.h"
 #include <QPainter>
 #include <QPalette>
 #include <QtMath>
 #include <QApplication>
 #include <QScreen>
+#include <QWindow>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <iostream>
 
 using namespace GameEnvironment;
 
-GameWindow::GameWindow() : QWidget()
+GameWindow::GameWindow(const QStringList &levels) : QWidget()
 {
 	setMinimumSize(minimumSizeHint());
-	//test
-	GameSettings testSettings;
-	testSettings.rings.append(Ring(40));
-
-	Ring ring(30, M_PI / 2);
-	ring.arcs.append({ 0, 0.3 });
-	ring.arcs.append({ 0.6, 0.2 });
-	testSettings.rings.append(ring);
-
-	ring.arcs.clear();
-	ring.width = 35;
-	ring.angleSpeed = -M_PI / 4.0;
-	ring.additionalRotation = M_PI / 4;
-	ring.arcs.append({ 0, 0.8 });
-	testSettings.rings.append(ring);
-
-	ring.arcs.clear();
-	ring.width = 40;
-	ring.angleSpeed = -M_PI / 2;
-	ring.additionalRotation = 0;
-	ring.arcs.append({ 0.4,0.1 });
-	ring.arcs.append({ 0.6,0.3 });
-	testSettings.rings.append(ring);
-
-	ring.arcs.clear();
-	ring.width = 35;
-	ring.angleSpeed = 0;
-	ring.arcs.append({ 0.1,0.4 });
-	ring.arcs.append({ 0.6,0.4 });
-	testSettings.rings.append(ring);
-
-	ring.arcs.clear();
-	ring.width = 40;
-	ring.angleSpeed = M_PI / 6;
-	ring.additionalRotation = 0.1 * M_PI;
-	ring.arcs.append({ 0,0.1 });
-	ring.arcs.append({ 0.3,0.05 });
-	ring.arcs.append({ 0.39,0.1 });
-	ring.arcs.append({ 0.6,0.05 });
-	ring.arcs.append({ 0.7,0.01 });
-	ring.arcs.append({ 0.78,0.2 });
-	testSettings.rings.append(ring);
-
-	ring.arcs.clear();
-	ring.width = 50;
-	ring.angleSpeed = -M_PI /2;
-	ring.additionalRotation = M_PI;
-	ring.arcs.append({ 0,0.3 });
-	ring.arcs.append({ 0.5,0.2 });
-	ring.arcs.append({ 0.8,0.1 });
-	testSettings.rings.append(ring);
-
-	testSettings.ringColors.append(Qt::blue);
-	testSettings.ringColors.append(Qt::yellow);
-	testSettings.ringColors.append(Qt::red);
-	testSettings.ringColors.append(Qt::GlobalColor::red);
-	testSettings.ringColors.append(Qt::green);
-	testSettings.ringColors.append(Qt::blue);
-
-	testSettings.energyCircutColor = Qt::transparent;
-	testSettings.energyColor = Qt::blue;
-	testSettings.freezeColor = Qt::red;
-	testSettings.energyRegenirationSpeed = 0.3;
-	testSettings.freezeRegenirationSpeed = 0.3;
-	testSettings.energyVolume = 4;
-	testSettings.freezeVolume = 5;
-	testSettings.goodClearingSpeed = -3;
-	testSettings.goodSpreadingSpeed = 3;
-	testSettings.goodColor = Qt::white;
-	testSettings.ringSelectingSpeed = 1.5;
-	testSettings.selectedRingBackgroundColor = Qt::gray;
-
-
 	//setting backGround
 	QPalette myPalette = palette();
 	myPalette.setColor(QPalette::ColorRole::Background, Qt::black);
 	setPalette(myPalette);
 
 
-	game = new Game(testSettings);
-	connect(game, &Game::Start, this, &GameWindow::startGame);
-	connect(game, &QThread::finished, this, &GameWindow::restartGame);
+	connect(qApp, &QCoreApplication::aboutToQuit, this, &GameWindow::saveRecording);
 	setMouseTracking(true);
-	game->start();
+
+	//the first level is needed before anything is shown, only the following ones are streamed
+	GameSettings settings = testLevel();
+	if (!levels.isEmpty())
+	{
+		if (loadLevel(levels[0], settings))
+			campaign = levels;
+		else
+			std::cerr << "cannot load level " << levels[0].toStdString() << std::endl;
+	}
+	if (campaign.count() > 1)
+		loader.load(campaign[1]);
+	connect(&loader, &QThread::finished, this, &GameWindow::levelLoaded);
+
+	game = new Game(settings);
+	connect(game, &Game::Start, this, &GameWindow::startGame);
+	//before the slots that save the recording
+	connect(game, &Game::GameWon, this, [this](double time) { claimRound(true, time); });
+	connect(game, &Game::GameOver, this, [this](double time) { claimRound(false, time); });
+	connect(game, &Game::GameWon, this, &GameWindow::nextLevel);
+	game->setCursorShape(GameEnvironment::CursorShape::arrow());
+	updateView();
+	game->startExecution();
 }
 
 GameWindow::~GameWindow()
 {
+	game->stopExecution();
+	game->wait();
 	delete game;
+	delete statePublisher;
+}
+
+void GameWindow::setRecordingPath(const QString & path)
+{
+	recordingPath = path;
+	game->setRecordingInput(!path.isEmpty());
+}
+
+bool GameWindow::setSharedStateKey(const QString & key)
+{
+	StatePublisher *publisher = new StatePublisher(key);
+	if (!publisher->open())
+	{
+		delete publisher;
+		return false;
+	}
+
+	game->setStatePublisher(publisher);
+	delete statePublisher;
+	statePublisher = publisher;
+	return true;
+}
+
+void GameWindow::setCursorShape(const CursorShape & shape)
+{
+	game->setCursorShape(shape);
+}
+
+void GameWindow::setScheduling(const SchedulingOptions & options)
+{
+	game->setScheduling(options);
+}
+
+void GameWindow::setJitterProfiler(JitterProfiler * profiler)
+{
+	game->setJitterProfiler(profiler);
+}
+
+void GameWindow::setLatencyProbe(LatencyProbe * probe)
+{
+	game->setLatencyProbe(probe);
+}
+
+void GameWindow::setRepaintInterval(int ms)
+{
+	repaintInterval = qMax(1, ms);
+}
+
+void GameWindow::nextLevel()
+{
+	if (campaign.count() < 2)
+		return;
+
+	GameLevel *next = loader.take();
+	if (!next)
+	{
+		//levelLoaded comes back here once the loader is done, the finished round stays on screen meanwhile
+		levelWanted = loader.isRunning();
+		return;
+	}
+
+	levelWanted = false;
+	currentLevel = (currentLevel + 1) % campaign.count();
+	killTimer(timerId);
+	gameStarted = false;
+	saveRecording();
+	game->restart(next);
+	loader.load(campaign[(currentLevel + 1) % campaign.count()]);
+}
+
+void GameWindow::levelLoaded()
+{
+	if (levelWanted)
+		nextLevel();
+}
+
+int GameWindow::renderMemoryUsage() const
+{
+	return game->renderMemoryUsage();
+}
+
+void GameWindow::updateView()
+{
+	int side = qMax(1, qMin(width(), height()));
+	view.viewport = QRect((width() - side) / 2, (height() - side) / 2, side, side);
+	view.origin = view.viewport.topLeft() + QPoint(side / 2, side / 2);
+	view.cornerDist = sqrt(pow(width(), 2.0) + pow(height(), 2.0)) / 2;
+	view.devicePixelRatio = devicePixelRatioF();
+
+	//the sprites for the new ratio are rendered here and not in the next paint
+	game->setDeviceScale(view.devicePixelRatio);
 }
 
 QSize GameWindow::minimumSizeHint() const
@@ -110,16 +158,8 @@ void GameWindow::mouseMoveEvent(QMouseEvent * event)
 {
 	if (gameStarted)
 	{
-		double dSide = static_cast<double>(side);
-		double k = dSide / static_cast<double>(logicalSquareSide);
-		double a = event->x();
-		double b = event->y();
-		double curX = (static_cast<double>(event->x()) - (width() - side) / 2 - side / 2) / k;
-		double curY = (static_cast<double>(event->y()) - (height() - side) / 2 - side / 2) / k;
-		double curWidth = cursorWidth / k;
-		double curHeight = cursorHeight / k;
-
-		game->setMouseRect(QRectF(curX, curY, curWidth, curHeight));
+		QPointF cursor = event->localPos() - view.origin;
+		game->setMouseRect(QRectF(cursor, QSizeF(cursorWidth, cursorHeight)));
 	}
 }
 
@@ -159,7 +199,10 @@ void GameWindow::keyPressEvent(QKeyEvent * event)
 			break;
 		}
 		case Qt::Key_R:
-			game->stopExecution();
+			restartGame();
+			break;
+		case Qt::Key_Backspace:
+			game->rewind(rewindSeconds);
 		}
 	}
 	QWidget::keyPressEvent(event);
@@ -174,17 +217,30 @@ void GameWindow::paintEvent(QPaintEvent * event)
 
 		game->drawUI(width(), height(), painter);
 
-		side = qMin(width(), height());
-		logicalSquareSide = side;
-		painter.setViewport((width() - side) / 2, (height() - side) / 2, side, side);
-		painter.setWindow(-logicalSquareSide / 2, -logicalSquareSide / 2, logicalSquareSide, logicalSquareSide);
+		int side = view.viewport.width();
+		painter.setViewport(view.viewport);
+		painter.setWindow(-side / 2, -side / 2, side, side);
 		painter.setPen(Qt::PenStyle::NoPen);
-		game->draw(sqrt(pow(width(), 2.0) + pow(height(), 2.0)) / 2, painter);
+		game->draw(view.cornerDist, painter);
 	}
 	else
 		QWidget::paintEvent(event);
 }
 
+void GameWindow::resizeEvent(QResizeEvent * event)
+{
+	updateView();
+	QWidget::resizeEvent(event);
+}
+
+void GameWindow::showEvent(QShowEvent * event)
+{
+	//the native window exists from the first show on, the device pixel ratio may differ on another screen
+	connect(windowHandle(), &QWindow::screenChanged, this, &GameWindow::updateView, Qt::UniqueConnection);
+	updateView();
+	QWidget::showEvent(event);
+}
+
 void GameWindow::timerEvent(QTimerEvent * event)
 {
 	if (event->timerId() == timerId)
@@ -195,12 +251,40 @@ void GameWindow::restartGame()
 {
 	killTimer(timerId);
 	gameStarted = false;
-	game->start();
+	saveRecording();
+	game->restart();
+}
+
+void GameWindow::saveRecording()
+{
+	if (recordingPath.isEmpty())
+		return;
+
+	saveInputRecording(recordingPath, game->inputRecording());
+	//an attempt cut short by a restart or quit has no outcome, the claim of an older round must not stay next to it
+	QFileInfo recording(recordingPath);
+	QString claimPath = recording.dir().filePath(recording.completeBaseName() + ".claim");
+	if (roundClaimed)
+		saveRunClaim(claimPath, claimedLevel, claimedWon, claimedTime);
+	else
+		QFile::remove(claimPath);
+	roundClaimed = false;
+}
+
+void GameWindow::claimRound(bool won, double time)
+{
+	roundClaimed = true;
+	claimedWon = won;
+	claimedTime = qRound(time);
+	if (campaign.isEmpty())
+		claimedLevel = "test";
+	else
+		claimedLevel = QFileInfo(recordingPath).dir().relativeFilePath(QFileInfo(campaign[currentLevel]).absoluteFilePath());
 }
 
 void GameWindow::startGame()
 {
-	timerId = startTimer(15);
+	timerId = startTimer(repaintInterval);
 	gameStarted = true;
 	QCursor::setPos(mapToGlobal(QPoint(0,0)));
 }
\ No newline at end of file
@@ -2,14 +2,25 @@
 #include <QWidget>
 #include <QTimerEvent>
 #include <QMouseEvent>
+#include <QResizeEvent>
+#include <QShowEvent>
 #include "gameenvironment.h"
+#include "levelloader.h"
 
 class GameWindow : public QWidget
 {
 	Q_OBJECT
 public:
-	GameWindow();
+	GameWindow(const QStringList &campaign = QStringList());//levels played in order, the next one is loaded in the background
 	~GameWindow();
+	void setRecordingPath(const QString &path);//input of the last attempt is saved there for replays, a finished round also writes its outcome to <name>.claim for --validate
+	bool setSharedStateKey(const QString &key);//every tick is published to shared memory under this key
+	void setCursorShape(const GameEnvironment::CursorShape &shape);
+	void setScheduling(const GameEnvironment::SchedulingOptions &options);
+	void setJitterProfiler(GameEnvironment::JitterProfiler *profiler);//not owned
+	void setLatencyProbe(GameEnvironment::LatencyProbe *probe);//not owned
+	void setRepaintInterval(int ms);
+	int renderMemoryUsage() const;//bytes
 
 	QSize minimumSizeHint() const;
 protected:
@@ -18,18 +29,46 @@ protected:
 	void mouseReleaseEvent(QMouseEvent *event);
 	void keyPressEvent(QKeyEvent *event);
 	void paintEvent(QPaintEvent* event);
+	void resizeEvent(QResizeEvent* event);
+	void showEvent(QShowEvent* event);
 	void timerEvent(QTimerEvent* event);
 private slots:
 	void startGame();
 	void restartGame();
+	void saveRecording();
+	void nextLevel();
+	void levelLoaded();
 private:
-	GameEnvironment::Game* game;
+	//Where the circle sits in the widget, shared by input and paint
+	struct ViewTransform
+	{
+		QRect viewport;//centered square the circle is drawn into, widget pixels are the units of Game::draw
+		QPoint origin;//widget pixel of the circle center
+		double cornerDist;//from the center to a widget corner
+		qreal devicePixelRatio;
+	};
+
+	void claimRound(bool won, double time);//saved with the recording of this round
+	void updateView();//after a resize or a screen change, also prepares the paint resources for the new size
+
+	GameEnvironment::Game* game = nullptr;
+	GameEnvironment::LevelLoader loader;
+	QStringList campaign;
+	int currentLevel = 0;
+	bool levelWanted = false;//the round was won while the next level was still loading
+	int repaintInterval = 15;
 	bool gameStarted = false;
 	int timerId;
+	QString recordingPath;
+	bool roundClaimed = false;//the round finished and its outcome waits for saveRecording
+	bool claimedWon = false;
+	int claimedTime = 0;//ms
+	QString claimedLevel;//relative to the directory of the recording
+	GameEnvironment::StatePublisher *statePublisher = nullptr;
 
-	int logicalSquareSide;
-	int side;
+	ViewTransform view;
 
 	const double cursorWidth = 10;
 	const double cursorHeight = 18;
+	const double rewindSeconds = 2;
 };
\ No newline at end of file
@@ -0,0 +1,51 @@
+#include "jitterprofiler.h"
+#include <algorithm>
+
+using namespace GameEnvironment;
+
+JitterProfiler::JitterProfiler(int capacity) : samples(qMax(capacity, 1))
+{
+}
+
+void JitterProfiler::record(double lateness)
+{
+	QMutexLocker locker(&mutex);
+	samples[next] = lateness;
+	next = (next + 1) % samples.count();
+	stored = qMin(stored + 1, samples.count());
+}
+
+void JitterProfiler::clear()
+{
+	QMutexLocker locker(&mutex);
+	next = 0;
+	stored = 0;
+}
+
+int JitterProfiler::count()
+{
+	QMutexLocker locker(&mutex);
+	return stored;
+}
+
+double JitterProfiler::percentile(double p)
+{
+	QMutexLocker locker(&mutex);
+	if (stored == 0)
+		return 0;
+
+	QVector<double> sorted = samples.mid(0, stored);
+	int index = qBound(0, int(p / 100 * (stored - 1) + 0.5), stored - 1);
+	std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+	return sorted[index];
+}
+
+void JitterProfiler::report(std::ostream & out, const char *name)
+{
+	out << name << ": " << count() << " samples, ms"
+		<< " p50 " << percentile(50)
+		<< " p90 " << percentile(90)
+		<< " p99 " << percentile(99)
+		<< " p99.9 " << percentile(99.9)
+		<< " max " << percentile(100) << std::endl;
+}
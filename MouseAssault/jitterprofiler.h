@@ -0,0 +1,26 @@
+#pragma once
+#include <QVector>
+#include <QMutex>
+#include <ostream>
+
+namespace GameEnvironment
+{
+	//Distribution of a duration in ms, how late ticks start compared to when they were scheduled by default.
+	//Keeps the latest capacity samples
+	class JitterProfiler
+	{
+	public:
+		JitterProfiler(int capacity = 100000);
+		void record(double lateness);//in ms
+		void clear();
+		int count();
+		double percentile(double p);//p from 0 to 100
+		void report(std::ostream &out, const char *name = "tick lateness");
+
+	private:
+		QMutex mutex;
+		QVector<double> samples;
+		int next = 0;
+		int stored = 0;
+	};
+}
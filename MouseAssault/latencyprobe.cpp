@@ -0,0 +1,31 @@
+#include "latencyprobe.h"
+
+using namespace GameEnvironment;
+
+LatencyProbe::LatencyProbe()
+{
+	clock.start();
+}
+
+qint64 LatencyProbe::now() const
+{
+	return clock.nsecsElapsed();
+}
+
+void LatencyProbe::record(const LatencyStamp & stamp, qint64 drawStart, qint64 drawEnd)
+{
+	stages[Pickup].record((stamp.picked - stamp.input) / 1e6);
+	stages[Simulation].record((stamp.published - stamp.picked) / 1e6);
+	stages[DisplayWait].record((drawStart - stamp.published) / 1e6);
+	stages[Drawing].record((drawEnd - drawStart) / 1e6);
+	stages[Total].record((drawEnd - stamp.input) / 1e6);
+}
+
+void LatencyProbe::report(std::ostream & out)
+{
+	stages[Pickup].report(out, "input to tick");
+	stages[Simulation].report(out, "tick to publish");
+	stages[DisplayWait].report(out, "publish to draw");
+	stages[Drawing].report(out, "draw");
+	stages[Total].report(out, "input to display");
+}
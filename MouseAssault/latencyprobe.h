@@ -0,0 +1,33 @@
+#pragma once
+#include <QElapsedTimer>
+#include <ostream>
+#include "jitterprofiler.h"
+
+namespace GameEnvironment
+{
+	//times in ns on the clock of a LatencyProbe, -1 while unknown
+	struct LatencyStamp
+	{
+		qint64 input = -1;//an input event arrived
+		qint64 picked = -1;//a tick took the event
+		qint64 published = -1;//the render commands of that tick were published
+	};
+
+	//Input to display latency. Every input event (mouse moves, buttons, freeze and rewind) is stamped when it
+	//reaches the game, the stamp travels with the render commands and is recorded by the first draw that shows it.
+	//Events shown by the same frame are measured by the oldest one
+	class LatencyProbe
+	{
+	public:
+		enum Stage { Pickup, Simulation, DisplayWait, Drawing, Total, StageCount };
+
+		LatencyProbe();
+		qint64 now() const;
+		void record(const LatencyStamp &stamp, qint64 drawStart, qint64 drawEnd);
+		void report(std::ostream &out);
+
+	private:
+		QElapsedTimer clock;
+		JitterProfiler stages[StageCount];
+	};
+}
@@ -0,0 +1,52 @@
+#include "levelloader.h"
+#include "gamedata.h"
+#include <iostream>
+
+using namespace GameEnvironment;
+
+LevelLoader::~LevelLoader()
+{
+	wait();
+	delete loadedLevel;
+	delete droppedLevel;
+}
+
+void LevelLoader::load(const QString & level)
+{
+	wait();
+	delete droppedLevel;
+	droppedLevel = loadedLevel;
+	loadedLevel = nullptr;
+
+	levelName = level;
+	start(QThread::LowPriority);
+}
+
+GameLevel * LevelLoader::take()
+{
+	if (isRunning())
+		return nullptr;
+	GameLevel *level = loadedLevel;
+	loadedLevel = nullptr;
+	return level;
+}
+
+QString LevelLoader::level() const
+{
+	return levelName;
+}
+
+void LevelLoader::run()
+{
+	delete droppedLevel;
+	droppedLevel = nullptr;
+
+	GameSettings settings;
+	if (!loadLevel(levelName, settings))
+	{
+		std::cerr << "cannot load level " << levelName.toStdString() << std::endl;
+		return;
+	}
+
+	loadedLevel = new GameLevel(settings);
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <QThread>
+#include <QString>
+#include "gameenvironment.h"
+
+namespace GameEnvironment
+{
+	//Builds the next level on its own thread while the current one is played: settings are parsed and
+	//GameLevel allocates the paint resources and the initial rings there. The running Game takes the
+	//finished level through Game::restart, so switching levels is a pointer hand over
+	class LevelLoader : public QThread
+	{
+	public:
+		~LevelLoader();
+		void load(const QString &level);//drops a level nobody took
+		GameLevel *take();//nullptr while loading or if the level could not be loaded, never waits. The caller owns the level
+		QString level() const;
+
+	protected:
+		void run();
+
+	private:
+		QString levelName;
+		GameLevel *loadedLevel = nullptr;
+		GameLevel *droppedLevel = nullptr;//deleted by the next run instead of the thread that called load
+	};
+}
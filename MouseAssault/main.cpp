@@ -1,10 +1,84 @@
 #include <QApplication>
+#include <QGuiApplication>
+#include <cstring>
 #include "gamewindowtest.h"
+#include "replayexporter.h"
+#include "benchmarks.h"
+#include "statepublisher.h"
+#include "jitterprofiler.h"
+#include "latencyprobe.h"
+#include "collisionoracle.h"
+#include "runvalidator.h"
+#include <iostream>
 
 int main(int argc, char *argv[])
 {
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--replay") == 0)
+		{
+			qputenv("QT_QPA_PLATFORM", "offscreen");
+			QGuiApplication a(argc, argv);
+			return GameEnvironment::ReplayExporter::run(a.arguments());
+		}
+		if (strcmp(argv[i], "--bench") == 0)
+		{
+			QCoreApplication a(argc, argv);
+			return GameEnvironment::Benchmarks::run(a.arguments());
+		}
+		if (strcmp(argv[i], "--fuzz") == 0)
+		{
+			QCoreApplication a(argc, argv);
+			return GameEnvironment::CollisionOracle::fuzz(a.arguments());
+		}
+		if (strcmp(argv[i], "--validate") == 0)
+		{
+			QCoreApplication a(argc, argv);
+			return GameEnvironment::RunValidator::run(a.arguments());
+		}
+		if (strcmp(argv[i], "--observe") == 0)
+		{
+			QCoreApplication a(argc, argv);
+			return GameEnvironment::StatePublisher::observe(a.arguments());
+		}
+	}
+
 	QApplication a(argc, argv);
-	GameWindow *window = new GameWindow();
+	QStringList campaign;
+	int campaignIndex = a.arguments().indexOf("--campaign");
+	if (campaignIndex > 0 && campaignIndex + 1 < a.arguments().count())
+		campaign = a.arguments()[campaignIndex + 1].split(',');
+	GameWindow *window = new GameWindow(campaign);
+	int record = a.arguments().indexOf("--record");
+	if (record > 0 && record + 1 < a.arguments().count())
+		window->setRecordingPath(a.arguments()[record + 1]);
+	int cursor = a.arguments().indexOf("--cursor");
+	GameEnvironment::CursorShape shape;
+	if (cursor > 0 && cursor + 1 < a.arguments().count() && GameEnvironment::CursorShape::fromString(a.arguments()[cursor + 1], shape))
+		window->setCursorShape(shape);
+	int share = a.arguments().indexOf("--share");
+	if (share > 0 && share + 1 < a.arguments().count())
+		window->setSharedStateKey(a.arguments()[share + 1]);
+	window->setScheduling(GameEnvironment::SchedulingOptions::fromArguments(a.arguments()));
+	GameEnvironment::JitterProfiler profiler;
+	if (a.arguments().contains("--jitter"))
+		window->setJitterProfiler(&profiler);
+	GameEnvironment::LatencyProbe probe;
+	if (a.arguments().contains("--latency"))
+		window->setLatencyProbe(&probe);
+	int repaint = a.arguments().indexOf("--repaint");
+	if (repaint > 0 && repaint + 1 < a.arguments().count())
+		window->setRepaintInterval(a.arguments()[repaint + 1].toInt());
 	window->show();
-	return a.exec();
-}
+	int result = a.exec();
+	int renderMemory = window->renderMemoryUsage();
+	delete window;
+	if (a.arguments().contains("--jitter"))
+		profiler.report(std::cout);
+	if (a.arguments().contains("--latency"))
+	{
+		probe.report(std::cout);
+		std::cout << "paint resources: " << renderMemory << " bytes" << std::endl;
+	}
+	return result;
+}
\ No newline at end of file
@@ -0,0 +1,241 @@
+#include "offscreenrenderer.h"
+#include <QPainter>
+#include <QRunnable>
+#include <QtMath>
+#include <algorithm>
+
+using namespace GameEnvironment;
+
+class OffscreenRenderer::TileWorker : public QRunnable
+{
+public:
+	TileWorker(OffscreenRenderer *renderer) : renderer(renderer) {}
+
+	void run()
+	{
+		int tile;
+		while ((tile = renderer->nextTile.fetchAndAddRelaxed(1)) < renderer->tilesCount)
+			renderer->renderTile(tile);
+	}
+
+private:
+	OffscreenRenderer *renderer;
+};
+
+OffscreenRenderer::OffscreenRenderer(const GameSettings & settings, QColor backgroundColor)
+	: settings(settings)
+{
+	background = { backgroundColor.redF(), backgroundColor.greenF(), backgroundColor.blueF() };
+	pool.setMaxThreadCount(QThread::idealThreadCount());
+}
+
+void OffscreenRenderer::setThreadCount(int count)
+{
+	pool.setMaxThreadCount(qMax(1, count));
+}
+
+void OffscreenRenderer::setTileSize(int size)
+{
+	tileSize = qMax(8, size);
+}
+
+void OffscreenRenderer::setSamplesPerAxis(int samples)
+{
+	samplesPerAxis = qMax(1, samples);
+}
+
+void OffscreenRenderer::render(const FrameState & frame, QImage & image)
+{
+	if (frame.rings.isEmpty())
+		return;
+
+	if (image.format() != QImage::Format_RGB32)
+		image = QImage(image.size(), QImage::Format_RGB32);
+
+	imageWidth = image.width();
+	imageHeight = image.height();
+	bits = image.bits();//detaches once here instead of inside the workers
+	bytesPerLine = image.bytesPerLine();
+
+	//same centering as the viewport GameWindow::paintEvent sets up
+	int side = qMin(imageWidth, imageHeight);
+	centerX = (imageWidth - side) / 2 + side / 2;
+	centerY = (imageHeight - side) / 2 + side / 2;
+
+	prepare(frame, sqrt(pow(imageWidth, 2.0) + pow(imageHeight, 2.0)) / 2);
+
+	tilesPerRow = (imageWidth + tileSize - 1) / tileSize;
+	tilesCount = tilesPerRow * ((imageHeight + tileSize - 1) / tileSize);
+	nextTile.store(0);
+
+	for (int i = 0; i < pool.maxThreadCount(); i++)
+		pool.start(new TileWorker(this));
+	pool.waitForDone();
+}
+
+void OffscreenRenderer::renderReference(Game & game, QImage & image, QColor backgroundColor)
+{
+	image.fill(backgroundColor);
+
+	QPainter painter(&image);
+	painter.setRenderHint(QPainter::Antialiasing, true);
+	painter.setBackground(backgroundColor);
+	painter.setPen(Qt::PenStyle::NoPen);
+
+	int side = qMin(image.width(), image.height());
+	painter.setViewport((image.width() - side) / 2, (image.height() - side) / 2, side, side);
+	painter.setWindow(-side / 2, -side / 2, side, side);
+	game.setDebugDrawing(false);
+	game.draw(sqrt(pow(image.width(), 2.0) + pow(image.height(), 2.0)) / 2, painter);
+}
+
+double OffscreenRenderer::mismatchRatio(const QImage & a, const QImage & b, int tolerance)
+{
+	if (a.size() != b.size())
+		return 1;
+
+	QImage first = a.convertToFormat(QImage::Format_RGB32);
+	QImage second = b.convertToFormat(QImage::Format_RGB32);
+	qint64 mismatches = 0;
+
+	for (int y = 0; y < first.height(); y++)
+	{
+		const QRgb *lineA = reinterpret_cast<const QRgb*>(first.constScanLine(y));
+		const QRgb *lineB = reinterpret_cast<const QRgb*>(second.constScanLine(y));
+		for (int x = 0; x < first.width(); x++)
+		{
+			if (qAbs(qRed(lineA[x]) - qRed(lineB[x])) > tolerance ||
+				qAbs(qGreen(lineA[x]) - qGreen(lineB[x])) > tolerance ||
+				qAbs(qBlue(lineA[x]) - qBlue(lineB[x])) > tolerance)
+				mismatches++;
+		}
+	}
+	return first.isNull() ? 0 : double(mismatches) / (double(first.width()) * first.height());
+}
+
+void OffscreenRenderer::prepare(const FrameState & frame, double cornerDist)
+{
+	layers.resize(frame.rings.count());
+	externalRadii.resize(frame.rings.count());
+	arcs.clear();
+
+	//painting goes from the outer ring to the core, so the colour left under every ring is known before the pixels are
+	Rgb inside = background;
+	QColor selection = settings.selectedRingBackgroundColor;
+	for (int i = frame.rings.count() - 1; i > 0; i--)
+	{
+		const Ring &ring = frame.rings[i];
+		Layer &layer = layers[i];
+		double ringRotation = ring.rotation + ring.additionalRotation;
+		double alpha = qBound(0.0, ring.selectedScore, 1.0);
+
+		layer.internalRadius = ring.internalRadius;
+		layer.externalRadius = ring.internalRadius + ring.width;
+		layer.base = { selection.redF() * alpha + inside.r * (1 - alpha),
+			selection.greenF() * alpha + inside.g * (1 - alpha),
+			selection.blueF() * alpha + inside.b * (1 - alpha) };
+
+		QColor color = i - 1 < settings.ringColors.count() ? settings.ringColors[i - 1] : QColor(Qt::transparent);
+		layer.color = { color.redF(), color.greenF(), color.blueF() };
+
+		layer.firstArc = arcs.count();
+		layer.arcCount = ring.arcs.count();
+		for (int j = 0; j < ring.arcs.count(); j++)
+		{
+			double start = fmod(ringRotation + ring.arcs[j].position * 2.0 * M_PI, 2.0 * M_PI);
+			if (start < 0)
+				start += 2.0 * M_PI;
+			arcs.append({ start, ring.arcs[j].length * 2.0 * M_PI });
+		}
+
+		inside = layer.arcCount > 0 ? background : layer.base;
+		externalRadii[i] = layer.externalRadius;
+	}
+
+	coreBase = inside;
+	coreRadius = frame.rings[0].width;
+	externalRadii[0] = coreRadius;
+
+	int radius = frame.rings[0].width;
+	int exRadius = radius + frame.coreWidthScore * (frame.gameWon ? cornerDist / 0.3 : radius);
+	coreGradient = exRadius == radius;
+	coreDiskRadius = coreGradient ? radius : int(exRadius * Game::goodColorBefore);
+}
+
+OffscreenRenderer::Rgb OffscreenRenderer::shade(double x, double y) const
+{
+	double r = sqrt(x * x + y * y);
+	Rgb color = background;
+
+	int index = std::lower_bound(externalRadii.constBegin(), externalRadii.constEnd(), r) - externalRadii.constBegin();
+	if (index == 0)
+		color = coreBase;
+	else if (index < layers.count())
+	{
+		const Layer &layer = layers[index];
+		color = layer.base;
+
+		double angle = Game::atan4(-y, x);
+		for (int j = layer.firstArc; j < layer.firstArc + layer.arcCount; j++)
+		{
+			double fromStart = angle - arcs[j].start;
+			if (fromStart < 0)
+				fromStart += 2.0 * M_PI;
+			if (fromStart < arcs[j].length)
+			{
+				color = layer.color;
+				break;
+			}
+		}
+	}
+
+	if (r <= coreDiskRadius)
+	{
+		QColor good = settings.goodColor;
+		double alpha = 1;
+		if (coreGradient)
+		{
+			double t = r / coreRadius;
+			if (t >= Game::evilColorAt)
+				alpha = 0;
+			else if (t > Game::goodColorBefore)
+				alpha = 1 - (t - Game::goodColorBefore) / (Game::evilColorAt - Game::goodColorBefore);
+		}
+		alpha *= good.alphaF();
+		color = { good.redF() * alpha + color.r * (1 - alpha),
+			good.greenF() * alpha + color.g * (1 - alpha),
+			good.blueF() * alpha + color.b * (1 - alpha) };
+	}
+	return color;
+}
+
+void OffscreenRenderer::renderTile(int tile)
+{
+	int xFrom = (tile % tilesPerRow) * tileSize;
+	int yFrom = (tile / tilesPerRow) * tileSize;
+	int xTo = qMin(xFrom + tileSize, imageWidth);
+	int yTo = qMin(yFrom + tileSize, imageHeight);
+
+	double samples = samplesPerAxis * samplesPerAxis;
+
+	for (int py = yFrom; py < yTo; py++)
+	{
+		QRgb *line = reinterpret_cast<QRgb*>(bits + py * bytesPerLine);
+		for (int px = xFrom; px < xTo; px++)
+		{
+			Rgb sum = { 0, 0, 0 };
+			for (int sy = 0; sy < samplesPerAxis; sy++)
+			{
+				for (int sx = 0; sx < samplesPerAxis; sx++)
+				{
+					Rgb sample = shade(px + (sx + 0.5) / samplesPerAxis - centerX,
+						py + (sy + 0.5) / samplesPerAxis - centerY);
+					sum.r += sample.r;
+					sum.g += sample.g;
+					sum.b += sample.b;
+				}
+			}
+			line[px] = qRgb(qRound(sum.r / samples * 255), qRound(sum.g / samples * 255), qRound(sum.b / samples * 255));
+		}
+	}
+}
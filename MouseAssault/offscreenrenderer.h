@@ -0,0 +1,76 @@
+#pragma once
+#include <QImage>
+#include <QColor>
+#include <QVector>
+#include <QThreadPool>
+#include "gameenvironment.h"
+
+namespace GameEnvironment
+{
+	//Rasterizes the Game::draw() part of a frame straight from the ring geometry,
+	//splitting the image into tiles that are shaded in parallel
+	class OffscreenRenderer
+	{
+	public:
+		OffscreenRenderer(const GameSettings &settings, QColor backgroundColor = Qt::black);
+		void setThreadCount(int count);
+		void setTileSize(int size);
+		void setSamplesPerAxis(int samples);
+		void render(const FrameState &frame, QImage &image);
+
+		static void renderReference(Game &game, QImage &image, QColor backgroundColor = Qt::black);//QPainter drawing of the game, turns its debug overlay off since the tiles have no counterpart for it
+		static double mismatchRatio(const QImage &a, const QImage &b, int tolerance);//part of pixels that differ more than tolerance in any channel
+
+	private:
+		class TileWorker;
+
+		struct Rgb
+		{
+			double r, g, b;
+		};
+
+		struct ArcSpan
+		{
+			double start;//radians from 0 to 2PI, counterclockwise from the x axis
+			double length;
+		};
+
+		struct Layer
+		{
+			double internalRadius;
+			double externalRadius;
+			Rgb color;
+			Rgb base;//what is left under the arcs after the outer rings and the selection were painted
+			int firstArc;
+			int arcCount;
+		};
+
+		void prepare(const FrameState &frame, double cornerDist);
+		Rgb shade(double x, double y) const;
+		void renderTile(int tile);
+
+		GameSettings settings;
+		Rgb background;
+		QThreadPool pool;
+		int tileSize = 64;
+		int samplesPerAxis = 2;
+
+		QVector<Layer> layers;
+		QVector<double> externalRadii;
+		QVector<ArcSpan> arcs;
+		Rgb coreBase;
+		double coreRadius;
+		double coreDiskRadius;
+		bool coreGradient;
+
+		uchar *bits;
+		int bytesPerLine;
+		int imageWidth;
+		int imageHeight;
+		int centerX;
+		int centerY;
+		int tilesPerRow;
+		int tilesCount;
+		QAtomicInt nextTile;
+	};
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QQueue>
+#include <functional>
+
+namespace GameEnvironment
+{
+	//blocking queue between pipeline stages, push waits while it is full
+	template<typename T>
+	class BoundedQueue
+	{
+	public:
+		BoundedQueue(int capacity) : capacity(capacity) {}
+
+		void push(const T &item)
+		{
+			QMutexLocker locker(&mutex);
+			while (items.count() >= capacity)
+				notFull.wait(&mutex);
+			items.enqueue(item);
+			notEmpty.wakeOne();
+		}
+
+		//false once the queue was closed and drained
+		bool pop(T &item)
+		{
+			QMutexLocker locker(&mutex);
+			while (items.isEmpty() && !closed)
+				notEmpty.wait(&mutex);
+			if (items.isEmpty())
+				return false;
+			item = items.dequeue();
+			notFull.wakeOne();
+			return true;
+		}
+
+		void close()
+		{
+			QMutexLocker locker(&mutex);
+			closed = true;
+			notEmpty.wakeAll();
+		}
+
+	private:
+		QQueue<T> items;
+		int capacity;
+		bool closed = false;
+		QMutex mutex;
+		QWaitCondition notEmpty;
+		QWaitCondition notFull;
+	};
+
+	class PipelineStage : public QThread
+	{
+	public:
+		PipelineStage(std::function<void()> work) : work(work) {}
+	protected:
+		void run() { work(); }
+	private:
+		std::function<void()> work;
+	};
+}
@@ -0,0 +1,85 @@
+#include "rendercache.h"
+#include <QPaintDevice>
+#include <QtMath>
+
+using namespace GameEnvironment;
+
+RenderCache::RenderCache(const QColor & selectionColor, const QRadialGradient & coreGradient, int coreRadius)
+	: coreGradient(coreGradient), coreRadius(coreRadius)
+{
+	selectionBrushes.reserve(alphaLevels);
+	for (int i = 0; i < alphaLevels; i++)
+	{
+		QColor color = selectionColor;
+		color.setAlphaF(i / double(alphaLevels - 1));
+		selectionBrushes.append(QBrush(color));
+	}
+}
+
+int RenderCache::alphaLevel(double alpha)
+{
+	return qRound(qBound(0.0, alpha, 1.0) * (alphaLevels - 1));
+}
+
+const QBrush & RenderCache::selectionBrush(int alphaLevel) const
+{
+	return selectionBrushes[alphaLevel];
+}
+
+void RenderCache::prepare(double scale, QPainter::RenderHints hints)
+{
+	coreSprite(coreRadius, scale, hints);
+}
+
+const QImage & RenderCache::coreSprite(int radius, double scale, QPainter::RenderHints hints)
+{
+	int scaleKey = qRound(scale * scaleSteps);
+	hints &= spriteHints;
+	for (int i = sprites.count() - 1; i >= 0; i--)
+	{
+		if (sprites[i].radius == radius && sprites[i].scaleKey == scaleKey && sprites[i].hints == hints)
+		{
+			if (i != sprites.count() - 1)
+			{
+				Sprite sprite = sprites[i];
+				sprites.remove(i);
+				sprites.append(sprite);
+			}
+			return sprites.last().image;
+		}
+	}
+
+	if (sprites.count() >= maxSprites)
+		sprites.remove(0);
+
+	double spriteScale = double(scaleKey) / scaleSteps;
+	int side = qMax(1, int(ceil(radius * 2 * spriteScale)));
+	QImage image(side, side, QImage::Format_ARGB32_Premultiplied);
+	image.fill(Qt::transparent);
+	QPainter painter(&image);
+	painter.setRenderHints(hints);
+	painter.setPen(Qt::NoPen);
+	painter.translate(side / 2.0, side / 2.0);
+	painter.scale(spriteScale, spriteScale);
+	painter.setBrush(coreGradient);
+	painter.drawEllipse(-radius, -radius, radius * 2, radius * 2);
+	painter.end();
+
+	sprites.append({ radius, scaleKey, hints, image });
+	return sprites.last().image;
+}
+
+int RenderCache::memoryUsage() const
+{
+	int bytes = sizeof(RenderCache) + selectionBrushes.capacity() * sizeof(QBrush);
+	for (const Sprite &sprite : sprites)
+		bytes += sizeof(Sprite) + sprite.image.byteCount();
+	return bytes;
+}
+
+double RenderCache::deviceScale(const QPainter & painter)
+{
+	QTransform transform = painter.combinedTransform();
+	double ratio = painter.device() ? painter.device()->devicePixelRatioF() : 1;
+	return sqrt(transform.m11() * transform.m11() + transform.m12() * transform.m12()) * ratio;
+}
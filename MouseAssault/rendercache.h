@@ -0,0 +1,46 @@
+#pragma once
+#include <QBrush>
+#include <QColor>
+#include <QImage>
+#include <QPainter>
+#include <QRadialGradient>
+#include <QVector>
+
+namespace GameEnvironment
+{
+	//Paint resources built ahead of the paint path. There is a selection brush for every 8 bit alpha level,
+	//and the core gradient is rendered to a sprite once per device scale and render hints by prepare, so replay only looks them up.
+	//Not locked, only the thread that paints the game may use it
+	class RenderCache
+	{
+	public:
+		RenderCache(const QColor &selectionColor, const QRadialGradient &coreGradient, int coreRadius);
+
+		static int alphaLevel(double alpha);//0 to alphaLevels - 1
+		const QBrush &selectionBrush(int alphaLevel) const;
+		void prepare(double scale, QPainter::RenderHints hints);//renders the core sprite ahead of paint
+		const QImage &coreSprite(int radius, double scale, QPainter::RenderHints hints);//rendered here only if prepare was not called for this scale
+		int memoryUsage() const;//bytes
+
+		static double deviceScale(const QPainter &painter);//device pixels per logical unit
+
+		static const int alphaLevels = 256;
+
+	private:
+		struct Sprite
+		{
+			int radius;
+			int scaleKey;
+			QPainter::RenderHints hints;//only spriteHints
+			QImage image;
+		};
+
+		QVector<QBrush> selectionBrushes;
+		QRadialGradient coreGradient;
+		int coreRadius;
+		QVector<Sprite> sprites;//most recently used last
+		const int maxSprites = 4;
+		const int scaleSteps = 64;//scales closer than 1/64 share a sprite
+		const QPainter::RenderHints spriteHints = QPainter::Antialiasing;//the hints that change how the sprite is rendered
+	};
+}
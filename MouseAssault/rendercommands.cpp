@@ -0,0 +1,74 @@
+#include "rendercommands.h"
+#include "gameenvironment.h"
+#include <QtMath>
+
+using namespace GameEnvironment;
+
+void RenderCommandList::build(const QVector<Ring>& rings, double coreWidthScore, bool gameWon, const RenderMotion & motion)
+{
+	size = 0;
+
+	int radius = rings.last().internalRadius + rings.last().width;
+	for (int i = rings.count() - 1; i > 0; i--)
+	{
+		const Ring &ring = rings[i];
+		double ringRotation = ring.rotation + ring.additionalRotation;
+		if (ring.selectedScore > 0 || ring.isSelected)
+		{
+			RenderCommand &selection = append();
+			selection.type = RenderCommand::Disk;
+			selection.brush = SelectionBrush;
+			selection.radius = radius;
+			selection.alpha = ring.selectedScore;
+			selection.alphaSpeed = ring.isSelected ? motion.selectingSpeed : -motion.selectingSpeed;
+		}
+
+		//rings the player holds still only move on input
+		double angleSpeed = ring.isRotating || motion.frozen ? 0 : qRadiansToDegrees(ring.angleSpeed) * 16 / 1000.0;
+
+		if (!ring.arcs.isEmpty())
+		{
+			for (int j = 0; j < ring.arcs.count(); j++)
+			{
+				const Arc &arc = ring.arcs[j];
+				RenderCommand &pie = append();
+				pie.type = RenderCommand::Pie;
+				pie.brush = FirstRingBrush + i - 1;
+				pie.radius = radius;
+				pie.startAngle = qRadiansToDegrees(ringRotation + arc.position * M_PI * 2) * 16;
+				pie.spanAngle = qRadiansToDegrees(2 * M_PI * arc.length) * 16;
+				pie.angleSpeed = angleSpeed;
+			}
+
+			RenderCommand &cut = append();
+			cut.type = RenderCommand::Disk;
+			cut.brush = BackgroundBrush;
+			cut.radius = radius - ring.width;
+		}
+		radius -= ring.width;
+	}
+
+	coreRadius = rings[0].width;
+	this->coreWidthScore = coreWidthScore;
+	this->gameWon = gameWon;
+	this->motion = motion;
+}
+
+void RenderCommandList::swap(RenderCommandList & other)
+{
+	commands.swap(other.commands);
+	qSwap(size, other.size);
+	qSwap(coreRadius, other.coreRadius);
+	qSwap(this->coreWidthScore, other.coreWidthScore);
+	qSwap(gameWon, other.gameWon);
+	qSwap(motion, other.motion);
+	qSwap(latency, other.latency);
+	qSwap(level, other.level);
+}
+
+RenderCommand & RenderCommandList::append()
+{
+	if (size == commands.count())
+		commands.resize(qMax(16, size * 2));
+	return commands[size++];
+}
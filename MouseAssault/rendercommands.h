@@ -0,0 +1,60 @@
+#pragma once
+#include <QVector>
+#include "latencyprobe.h"
+
+namespace GameEnvironment
+{
+	struct Ring;
+	class GameLevel;
+
+	struct RenderCommand
+	{
+		enum Type { Disk, Pie };
+
+		Type type;
+		int brush;//RenderCommandList::Brush or FirstRingBrush + ring index - 1
+		int radius;
+		int startAngle;//in 1/16 of a degree, Pie only
+		int spanAngle;
+		double angleSpeed;//1/16 of a degree per ms, Pie only
+		double alpha;//SelectionBrush only
+		double alphaSpeed;//per ms, SelectionBrush only
+	};
+
+	//How the rings move until the next tick. Between input events everything the simulation changes
+	//is linear in time, so draw can evaluate the commands at its own time instead of the tick time
+	struct RenderMotion
+	{
+		double time = 0;//the tick time the commands were built at
+		bool frozen = false;
+		double selectingSpeed = 0;//per ms
+		double coreSpeed = 0;//per ms, only while the core grows or shrinks after the game finished
+	};
+
+	//Everything Game::draw paints for the rings, resolved once per tick by the simulation.
+	//Commands keep the painting order between rings; inside a ring all pies share one brush
+	//and the background disk that cuts them is drawn once instead of after every arc
+	class RenderCommandList
+	{
+	public:
+		enum Brush { BackgroundBrush, SelectionBrush, FirstRingBrush };
+
+		void build(const QVector<Ring> &rings, double coreWidthScore, bool gameWon, const RenderMotion &motion = RenderMotion());
+		void swap(RenderCommandList &other);
+		const RenderCommand &operator[](int i) const { return commands[i]; }
+		int count() const { return size; }
+
+		int coreRadius = 0;
+		double coreWidthScore = 0;
+		bool gameWon = false;
+		RenderMotion motion;
+		LatencyStamp latency;//the oldest input event no draw has shown yet
+		GameLevel *level = nullptr;//whose resources paint the commands
+
+	private:
+		RenderCommand &append();
+
+		QVector<RenderCommand> commands;//only grows, count() tells how many are in use
+		int size = 0;
+	};
+}
@@ -0,0 +1,209 @@
+#include "replayexporter.h"
+#include "gamedata.h"
+#include "offscreenrenderer.h"
+#include "pipeline.h"
+#include <QCommandLineParser>
+#include <QDir>
+#include <QFile>
+#include <QPainter>
+#include <QElapsedTimer>
+#include <QtMath>
+#include <iostream>
+
+using namespace GameEnvironment;
+
+ReplayExporter::ReplayExporter(const GameSettings & settings, const InputRecording & recording, const ReplayOptions & options)
+	: settings(settings), recording(recording), options(options)
+{
+}
+
+int ReplayExporter::exportFrames()
+{
+	if (!QDir().mkpath(options.outputDir))
+		return -1;
+
+	QFile rawFile(QDir(options.outputDir).filePath("frames.rgba"));
+	if (options.rawRgba && !rawFile.open(QIODevice::WriteOnly))
+		return -1;
+
+	Game game(settings);
+	game.setCursorShape(options.cursor);
+	bool finished = false;
+	QObject::connect(&game, &Game::GameWon, &game, [&finished]() { finished = true; }, Qt::DirectConnection);
+	QObject::connect(&game, &Game::GameOver, &game, [&finished]() { finished = true; }, Qt::DirectConnection);
+
+	BoundedQueue<FrameState> frames(4);
+	BoundedQueue<RenderedFrame> images(4);
+	int written = 0;
+	bool failed = false;
+
+	PipelineStage simulation([&]()
+	{
+		int endTime = (recording.isEmpty() ? 0 : recording.last().time) + options.tail;
+		int lastTick = -1;
+		for (int i = 0; i < recording.count(); i++)
+			if (recording[i].type == InputEvent::Tick)
+				lastTick = i;
+		int next = 0;
+
+		game.reset();
+		for (int frame = 0; !finished; frame++)
+		{
+			int time = frame * 1000 / options.fps;
+			if (time > endTime)
+				break;
+
+			//inputs are applied at their own timestamps so fast mouse moves are not skipped between frames.
+			//Recorded ticks are replayed as they are, a frame between them shows the state of the last one
+			for (; next < recording.count() && recording[next].time <= time; next++)
+			{
+				if (recording[next].type == InputEvent::Tick)
+					game.tick(recording[next].time);
+				else
+				{
+					game.applyInput(recording[next]);
+					if (lastTick < 0)
+						game.tick(recording[next].time);
+				}
+			}
+			if (next > lastTick)
+				game.tick(time);
+			frames.push(game.frameState());
+		}
+		frames.close();
+	});
+
+	PipelineStage rendering([&]()
+	{
+		OffscreenRenderer renderer(settings);
+		int width = options.size.width();
+		int height = options.size.height();
+		int side = qMin(width, height);
+		double cornerDist = sqrt(pow(width, 2.0) + pow(height, 2.0)) / 2;
+
+		FrameState frame;
+		for (int index = 0; frames.pop(frame); index++)
+		{
+			QImage image(options.size, QImage::Format_RGB32);
+			if (options.tiled)
+				renderer.render(frame, image);
+			else
+				image.fill(Qt::black);
+
+			QPainter painter(&image);
+			painter.setRenderHint(QPainter::Antialiasing, true);
+			painter.setBackground(QColor(Qt::black));
+			painter.setPen(Qt::PenStyle::NoPen);
+
+			game.drawUI(frame, width, height, painter);
+
+			if (!options.tiled)
+			{
+				painter.setViewport((width - side) / 2, (height - side) / 2, side, side);
+				painter.setWindow(-side / 2, -side / 2, side, side);
+				painter.setPen(Qt::PenStyle::NoPen);
+				game.draw(frame, cornerDist, painter);
+			}
+			painter.end();
+
+			images.push({ index, image });
+		}
+		images.close();
+	});
+
+	PipelineStage encoding([&]()
+	{
+		RenderedFrame rendered;
+		while (images.pop(rendered))
+		{
+			bool saved;
+			if (options.rawRgba)
+			{
+				QImage rgba = rendered.image.convertToFormat(QImage::Format_RGBA8888);
+				saved = true;
+				for (int y = 0; y < rgba.height() && saved; y++)
+					saved = rawFile.write(reinterpret_cast<const char*>(rgba.constScanLine(y)), rgba.width() * 4) == rgba.width() * 4;
+			}
+			else
+				saved = rendered.image.save(QDir(options.outputDir).filePath(QString("frame_%1.png").arg(rendered.index, 5, 10, QChar('0'))));
+
+			if (saved)
+				written++;
+			else
+				failed = true;
+		}
+	});
+
+	simulation.start();
+	rendering.start();
+	encoding.start();
+	simulation.wait();
+	rendering.wait();
+	encoding.wait();
+
+	return failed ? -1 : written;
+}
+
+int ReplayExporter::run(const QStringList & arguments)
+{
+	QCommandLineParser parser;
+	parser.addPositionalArgument("level", "Built-in level name or json level file.");
+	parser.addPositionalArgument("input", "Recorded input stream.");
+	parser.addPositionalArgument("output", "Directory for the frames.");
+	parser.addOption(QCommandLineOption("replay"));
+	parser.addOption(QCommandLineOption("fps", "Frames per second.", "fps", "60"));
+	parser.addOption(QCommandLineOption("size", "Frame size as WIDTHxHEIGHT.", "size", "800x600"));
+	parser.addOption(QCommandLineOption("format", "png or rgba.", "format", "png"));
+	parser.addOption(QCommandLineOption("tail", "Milliseconds simulated after the last input.", "ms", "3000"));
+	parser.addOption(QCommandLineOption("tiled", "Rasterize rings with the tiled offscreen renderer."));
+	parser.addOption(QCommandLineOption("cursor", "Cursor shape: rect, arrow or a list of x,y points.", "shape", "arrow"));
+
+	if (!parser.parse(arguments) || parser.positionalArguments().count() != 3)
+	{
+		std::cerr << "usage: MouseAssault --replay <level> <input> <output> [--fps N] [--size WxH] [--format png|rgba] [--tail ms] [--tiled]" << std::endl;
+		return 1;
+	}
+
+	QStringList positional = parser.positionalArguments();
+	GameSettings settings;
+	if (!loadLevel(positional[0], settings))
+	{
+		std::cerr << "cannot load level " << positional[0].toStdString() << std::endl;
+		return 1;
+	}
+
+	InputRecording recording;
+	if (!loadInputRecording(positional[1], recording))
+	{
+		std::cerr << "cannot load input " << positional[1].toStdString() << std::endl;
+		return 1;
+	}
+
+	ReplayOptions options;
+	options.outputDir = positional[2];
+	options.rawRgba = parser.value("format") == "rgba";
+	options.tiled = parser.isSet("tiled");
+	options.fps = qMax(1, parser.value("fps").toInt());
+	options.tail = parser.value("tail").toInt();
+	if (!CursorShape::fromString(parser.value("cursor"), options.cursor))
+	{
+		std::cerr << "bad cursor shape: " << parser.value("cursor").toStdString() << std::endl;
+		return 1;
+	}
+	QStringList size = parser.value("size").split('x');
+	if (size.count() == 2 && size[0].toInt() > 0 && size[1].toInt() > 0)
+		options.size = QSize(size[0].toInt(), size[1].toInt());
+
+	QElapsedTimer timer;
+	timer.start();
+	int written = ReplayExporter(settings, recording, options).exportFrames();
+	if (written < 0)
+	{
+		std::cerr << "cannot write frames to " << options.outputDir.toStdString() << std::endl;
+		return 1;
+	}
+
+	std::cout << written << " frames " << options.size.width() << "x" << options.size.height()
+		<< " written in " << timer.elapsed() << " ms" << std::endl;
+	return 0;
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <QString>
+#include <QStringList>
+#include <QSize>
+#include <QImage>
+#include "gameenvironment.h"
+
+namespace GameEnvironment
+{
+	struct ReplayOptions
+	{
+		QString outputDir;
+		bool rawRgba = false;//one frames.rgba stream instead of a png per frame
+		bool tiled = false;//OffscreenRenderer instead of QPainter for the rings
+		int fps = 60;
+		QSize size = QSize(800, 600);
+		int tail = 3000;//ms simulated after the last input event
+		CursorShape cursor = CursorShape::arrow();//has to match the shape the input was recorded with
+	};
+
+	//Replays a recorded input stream against a level and writes every frame to disk.
+	//Simulation, rendering and encoding run on separate threads connected by bounded queues
+	class ReplayExporter
+	{
+	public:
+		ReplayExporter(const GameSettings &settings, const InputRecording &recording, const ReplayOptions &options);
+		int exportFrames();//number of written frames, -1 on error
+
+		static int run(const QStringList &arguments);//--replay command line mode
+
+	private:
+		struct RenderedFrame
+		{
+			int index;
+			QImage image;
+		};
+
+		GameSettings settings;
+		InputRecording recording;
+		ReplayOptions options;
+	};
+}
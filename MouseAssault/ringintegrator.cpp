@@ -0,0 +1,241 @@
+#include "ringintegrator.h"
+#include <QRunnable>
+#include <QtMath>
+
+using namespace GameEnvironment;
+
+class RingIntegrator::ChunkWorker : public QRunnable
+{
+public:
+	ChunkWorker(RingIntegrator *integrator) : integrator(integrator) {}
+
+	void run()
+	{
+		integrator->workChunks();
+	}
+
+private:
+	RingIntegrator *integrator;
+};
+
+RingIntegrator::RingIntegrator()
+{
+	pool.setMaxThreadCount(QThread::idealThreadCount());
+}
+
+RingIntegrator::~RingIntegrator()
+{
+	delete staticIntegration;
+}
+
+void RingIntegrator::setThreadCount(int count)
+{
+	pool.setMaxThreadCount(qMax(1, count));
+}
+
+void RingIntegrator::setParallelThreshold(int rings)
+{
+	parallelThreshold = qMax(chunkSize, rings);
+}
+
+void RingIntegrator::setBinaryArcs(const QVector<Ring>& rings)
+{
+	binaryArcs.clear();
+	binaryArcBegin.clear();
+	if (rings.isEmpty())
+		return;
+
+	for (int i = 0; i < rings.count(); i++)
+	{
+		binaryArcBegin.append(binaryArcs.count());
+		for (int j = 0; j < rings[i].arcs.count(); j++)
+			binaryArcs.append(BinaryAngles::fromArc(rings[i].arcs[j]));
+	}
+	binaryArcBegin.append(binaryArcs.count());
+}
+
+void RingIntegrator::setStaticIntegration(StaticRingIntegration * integration)
+{
+	if (integration == staticIntegration)
+		return;
+	delete staticIntegration;
+	staticIntegration = integration;
+}
+
+int RingIntegrator::integrate(const QVector<Ring>& source, QVector<Ring>& target, const RingStep & step, double & horizon)
+{
+	if (staticIntegration && binaryArcBegin.isEmpty() && source.count() == staticIntegration->ringCount())
+		return staticIntegration->integrate(source, target, step, horizon);
+
+	ringCount = source.count();
+	target.resize(ringCount);
+	sourceRings = source.constData();
+	targetRings = target.data();//detaches once here instead of inside the workers
+	this->step = &step;
+
+	if (ringCount < parallelThreshold || pool.maxThreadCount() < 2)
+	{
+		if (chunks.isEmpty())
+			chunks.resize(1);
+		integrateRange(0, ringCount, step.finished, chunks[0]);
+		horizon = qMin(horizon, chunks[0].horizon);
+		return chunks[0].finisher;
+	}
+
+	int count = (ringCount + chunkSize - 1) / chunkSize;
+	if (chunks.count() < count)
+		chunks.resize(count);
+	runChunks(0, count, step.finished);
+
+	//the serial loop sees the game finished from the first finishing ring on
+	for (int i = 0; i < count; i++)
+	{
+		horizon = qMin(horizon, chunks[i].horizon);
+		if (chunks[i].finisher >= 0)
+		{
+			if (i + 1 < count)
+				runChunks(i + 1, count, true);
+			return chunks[i].finisher;
+		}
+	}
+	return -1;
+}
+
+Collision::Outcome RingIntegrator::integrateRing(Ring & ring, int index, bool finished, Chunk & chunk) const
+{
+	double fullRotation = 0;
+	if (index != 0)
+	{
+		if (ring.isRotating || (step->frozen && !finished))
+		{
+			ring.additionalRotation += ring.rotation - ring.angleSpeed * step->deltaTime / double(1000);
+			ring.additionalRotation = Circle::adjustAngle(ring.additionalRotation);
+		}
+		ring.rotation = Circle::adjustAngle(ring.angleSpeed * step->deltaTime / double(1000));
+		fullRotation = ring.additionalRotation + ring.rotation;
+
+		if (ring.isRotating && !step->rotating)
+			ring.isRotating = false;
+	}
+
+	double sqrExternalRadius = pow(ring.internalRadius + ring.width, 2.0);
+	double sqrInternalRadius = pow(ring.internalRadius, 2.0);
+
+	bool touches = step->polygon ? Collision::touchesRing(*step->polygon, sqrInternalRadius, sqrExternalRadius)
+		: Collision::touchesRing(step->mouseRect, sqrInternalRadius, sqrExternalRadius);
+	if (!touches || finished)
+	{
+		ring.isRotating = false;
+		if (ring.isSelected)
+		{
+			ring.isSelected = false;
+			ring.lastSelectionScore = ring.selectedScore;
+			ring.selectionStartTime = step->deltaTime;
+		}
+		if (ring.selectedScore > 0)
+			ring.selectedScore = qMax(ring.lastSelectionScore - step->selectingSpeed * (step->deltaTime - ring.selectionStartTime) / double(1000), 0.0);
+		return Collision::None;
+	}
+
+	if (index == 0)
+		return Collision::Won;
+
+	Collision::Outcome outcome = Collision::None;
+	chunk.points.clear();
+	if (step->polygon)
+	{
+		Collision::intersectionPoints(*step->polygon, sqrInternalRadius, sqrExternalRadius, chunk.points);
+		Collision::pointAngles(chunk.points, chunk.angles);
+	}
+	else
+		Collision::intersectionPoints(step->mouseRect, sqrInternalRadius, sqrExternalRadius, chunk.points);
+
+	if (binaryArcBegin.count() == ringCount + 1)
+	{
+		BinaryAngle rotation = BinaryAngles::fromRadians(fullRotation);
+		Collision::binaryPointAngles(chunk.points, chunk.binaryAngles);
+		for (int j = binaryArcBegin[index]; j < binaryArcBegin[index + 1]; j++)
+		{
+			const BinaryArc &arc = binaryArcs[j];
+			bool hit = Collision::binaryArcHit(chunk.binaryAngles, rotation, arc);
+			if (!hit && step->polygon)
+			{
+				hit = Collision::edgeHit(*step->polygon, chunk.angles, BinaryAngles::toRadians(rotation + arc.start),
+					BinaryAngles::toRadians(rotation + arc.start + arc.length), ring.internalRadius, ring.internalRadius + ring.width);
+			}
+			if (hit)
+				outcome = Collision::Lost;
+		}
+	}
+	else
+	{
+		for (int j = 0; j < ring.arcs.count(); j++)
+		{
+			bool hit = step->polygon ? Collision::sectorHit(*step->polygon, chunk.angles, fullRotation, ring.arcs[j], ring.internalRadius, ring.internalRadius + ring.width)
+				: Collision::arcHit(chunk.points, fullRotation, ring.arcs[j]);
+			if (hit)
+				outcome = Collision::Lost;
+		}
+	}
+
+	//a still cursor can only be hit by an arc turning into it
+	if (outcome == Collision::None && !ring.isRotating && !step->frozen)
+	{
+		if (!step->polygon)
+			Collision::pointAngles(chunk.points, chunk.angles);
+		for (int j = 0; j < ring.arcs.count(); j++)
+			chunk.horizon = qMin(chunk.horizon, Collision::contactTime(chunk.angles, fullRotation, ring.arcs[j], ring.angleSpeed) * 1000);
+	}
+
+	if (step->rotating)
+	{
+		ring.isRotating = true;
+		ring.additionalRotation = Circle::adjustAngle(ring.additionalRotation + step->mouseAngleDifference);
+	}
+
+	if (!ring.isSelected)
+	{
+		ring.isSelected = true;
+		ring.lastSelectionScore = ring.selectedScore;
+		ring.selectionStartTime = step->deltaTime;
+	}
+	if (ring.selectedScore < 1)
+		ring.selectedScore = qMin(ring.lastSelectionScore + step->selectingSpeed * (step->deltaTime - ring.selectionStartTime) / double(1000), 1.0);
+	return outcome;
+}
+
+void RingIntegrator::integrateRange(int begin, int end, bool finished, Chunk & chunk)
+{
+	chunk.finisher = -1;
+	chunk.horizon = INFINITY;
+	for (int i = begin; i < end; i++)
+	{
+		targetRings[i] = sourceRings[i];
+		if (integrateRing(targetRings[i], i, finished, chunk) != Collision::None && chunk.finisher < 0)
+		{
+			chunk.finisher = i;
+			finished = true;
+		}
+	}
+}
+
+void RingIntegrator::runChunks(int first, int last, bool finished)
+{
+	chunksFinished = finished;
+	lastChunk = last;
+	nextChunk.store(first);
+
+	//the calling thread takes chunks too instead of only waiting
+	int workers = qMin(pool.maxThreadCount(), last - first) - 1;
+	for (int i = 0; i < workers; i++)
+		pool.start(new ChunkWorker(this));
+	workChunks();
+	pool.waitForDone();
+}
+
+void RingIntegrator::workChunks()
+{
+	int chunk;
+	while ((chunk = nextChunk.fetchAndAddRelaxed(1)) < lastChunk)
+		integrateRange(chunk * chunkSize, qMin((chunk + 1) * chunkSize, ringCount), chunksFinished, chunks[chunk]);
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include <QVector>
+#include <QRectF>
+#include <QPointF>
+#include <QThreadPool>
+#include <QAtomicInt>
+#include "gameenvironment.h"
+#include "collision.h"
+
+namespace GameEnvironment
+{
+	//What a tick hands to the update of every ring
+	struct RingStep
+	{
+		double deltaTime;
+		double mouseAngleDifference;
+		double selectingSpeed;//selection score per sec
+		bool rotating;
+		bool frozen;
+		bool finished;//the game was finished before this tick
+		QRectF mouseRect;
+		const CursorPolygon *polygon;//nullptr tests mouseRect
+	};
+
+	//Same update for a level whose ring and arc counts are known at compile time, see StaticLevelIntegration
+	class StaticRingIntegration
+	{
+	public:
+		virtual ~StaticRingIntegration() {}
+		virtual int ringCount() const = 0;
+		virtual int integrate(const QVector<Ring> &source, QVector<Ring> &target, const RingStep &step, double &horizon) = 0;
+	};
+
+	//Moves, selects and hit tests the rings of one tick. A ring only depends on the others through the first ring
+	//that finishes the game, so big levels are updated in chunks on a thread pool and the chunks are reduced
+	//in ring order, which gives exactly the result of the serial loop
+	class RingIntegrator
+	{
+	public:
+		RingIntegrator();
+		~RingIntegrator();
+		void setThreadCount(int count);//1 keeps every level on the calling thread
+		void setParallelThreshold(int rings);//smaller levels are updated on the calling thread
+		void setBinaryArcs(const QVector<Ring> &rings);//arcs of these rings are tested with binary angles, no rings go back to radians
+		void setStaticIntegration(StaticRingIntegration *integration);//owned, used instead of the dynamic loop while binary arcs are off, nullptr removes it
+
+		//target gets the updated source rings, horizon is lowered to the next contact in ms.
+		//Returns the ring that finishes the game or -1, ring 0 is the core and wins it
+		int integrate(const QVector<Ring> &source, QVector<Ring> &target, const RingStep &step, double &horizon);
+
+	private:
+		class ChunkWorker;
+
+		struct Chunk
+		{
+			int finisher;
+			double horizon;
+			QVector<QPointF> points;
+			QVector<double> angles;
+			QVector<BinaryAngle> binaryAngles;
+		};
+
+		Collision::Outcome integrateRing(Ring &ring, int index, bool finished, Chunk &chunk) const;
+		void integrateRange(int begin, int end, bool finished, Chunk &chunk);
+		void runChunks(int first, int last, bool finished);
+		void workChunks();
+
+		QThreadPool pool;
+		int parallelThreshold = 1024;
+		const int chunkSize = 256;
+		QVector<Chunk> chunks;
+		QVector<BinaryArc> binaryArcs;
+		QVector<int> binaryArcBegin;//arcs of ring i are binaryArcs[binaryArcBegin[i]] up to binaryArcBegin[i + 1]
+		StaticRingIntegration *staticIntegration = nullptr;
+
+		const Ring *sourceRings;
+		Ring *targetRings;
+		int ringCount;
+		const RingStep *step;
+		bool chunksFinished;
+		int lastChunk;
+		QAtomicInt nextChunk;
+	};
+}
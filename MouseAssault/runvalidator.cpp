@@ -0,0 +1,290 @@
+#include "runvalidator.h"
+#include "gamedata.h"
+#include <QCommandLineParser>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QRunnable>
+#include <QElapsedTimer>
+#include <iostream>
+#include <iomanip>
+
+using namespace GameEnvironment;
+
+class RunValidator::RunWorker : public QRunnable
+{
+public:
+	RunWorker(RunValidator *validator) : validator(validator) {}
+
+	~RunWorker()
+	{
+		qDeleteAll(games);
+	}
+
+	void run()
+	{
+		int run;
+		while ((run = validator->nextRun.fetchAndAddRelaxed(1)) < validator->runClaims.count())
+		{
+			const RunClaim &claim = validator->runClaims.at(run);
+			if (!validator->runResults.at(run).error.isEmpty())
+				continue;
+
+			QElapsedTimer timer;
+			timer.start();
+			result = &validator->runResults[run];
+			simulate(game(claim.level), claim.recording);
+			result->nsecs = timer.nsecsElapsed();
+		}
+	}
+
+private:
+	//one Game per level, reset between runs
+	Game &game(const QString &level)
+	{
+		Game *game = games.value(level);
+		if (!game)
+		{
+			game = new Game(validator->levels.value(level));
+			game->setCursorShape(validator->cursor);
+			game->setParallelIntegration(1, 0);//the pool already keeps every core busy
+			QObject::connect(game, &Game::GameWon, game, [this](double time) { finish(true, time); }, Qt::DirectConnection);
+			QObject::connect(game, &Game::GameOver, game, [this](double time) { finish(false, time); }, Qt::DirectConnection);
+			games.insert(level, game);
+		}
+		return *game;
+	}
+
+	void finish(bool won, double time)
+	{
+		result->finished = true;
+		result->won = won;
+		result->time = time;
+	}
+
+	void simulate(Game &game, const InputRecording &recording)
+	{
+		double endTime = (recording.isEmpty() ? 0 : recording.last().time) + validator->tail;
+		bool recordedTicks = false;
+		for (const InputEvent &event : recording)
+			recordedTicks |= event.type == InputEvent::Tick;
+		int next = 0;
+		double time = 0;
+
+		game.reset();
+		if (!recordedTicks)
+			game.tick(time);
+		while (!result->finished)
+		{
+			double scheduled = game.nextTickTime();
+			if (recordedTicks && next < recording.count())
+			{
+				//the live game ticked here and took every event recorded since its previous tick
+				const InputEvent &event = recording[next++];
+				if (event.type != InputEvent::Tick)
+				{
+					game.applyInput(event);
+					continue;
+				}
+				time = event.time;
+			}
+			else if (next < recording.count() && recording[next].time <= scheduled)
+			{
+				//older recordings without ticks: input wakes the thread before the scheduled tick
+				time = recording[next].time;
+				game.applyInput(recording[next++]);
+			}
+			else if (scheduled <= endTime)
+				time = scheduled;
+			else
+				break;
+			game.tick(time);
+		}
+	}
+
+	RunValidator *validator;
+	QHash<QString, Game*> games;
+	RunResult *result = nullptr;//the run being simulated
+};
+
+RunValidator::RunValidator()
+{
+	pool.setMaxThreadCount(QThread::idealThreadCount());
+}
+
+RunValidator::~RunValidator()
+{
+}
+
+void RunValidator::setThreadCount(int count)
+{
+	pool.setMaxThreadCount(qMax(1, count));
+}
+
+void RunValidator::setCursorShape(const CursorShape & shape)
+{
+	cursor = shape;
+}
+
+void RunValidator::setTail(int ms)
+{
+	tail = qMax(0, ms);
+}
+
+void RunValidator::setTolerance(double ms)
+{
+	tolerance = qMax(0.0, ms);
+}
+
+bool RunValidator::load(const QString & directory)
+{
+	QDir dir(directory);
+	QStringList files = dir.entryList(QStringList() << "*.claim", QDir::Files, QDir::Name);
+
+	runClaims.clear();
+	runResults.clear();
+	for (int i = 0; i < files.count(); i++)
+	{
+		RunClaim claim;
+		RunResult result;
+		claim.name = QFileInfo(files[i]).completeBaseName();
+		claim.won = false;
+		claim.time = 0;
+
+		//<level> won|lost <ms>
+		QFile file(dir.filePath(files[i]));
+		QStringList fields;
+		if (file.open(QIODevice::ReadOnly | QIODevice::Text))
+			fields = QTextStream(&file).readLine().split(' ', QString::SkipEmptyParts);
+		bool timeValid = false;
+		if (fields.count() == 3)
+			claim.time = fields[2].toInt(&timeValid);
+		if (!timeValid || (fields[1] != "won" && fields[1] != "lost"))
+			result.error = "bad claim";
+		else
+		{
+			claim.level = fields[0] == "test" ? fields[0] : dir.filePath(fields[0]);
+			claim.won = fields[1] == "won";
+
+			if (!levels.contains(claim.level))
+			{
+				GameSettings settings;
+				if (loadLevel(claim.level, settings))
+					levels.insert(claim.level, settings);
+			}
+			if (!levels.contains(claim.level))
+				result.error = "cannot load level " + fields[0];
+			else if (!loadInputRecording(dir.filePath(claim.name + ".input"), claim.recording))
+				result.error = "cannot load input";
+		}
+
+		runClaims.append(claim);
+		runResults.append(result);
+	}
+	return !runClaims.isEmpty();
+}
+
+void RunValidator::validate()
+{
+	nextRun.store(0);
+	for (int i = 0; i < pool.maxThreadCount(); i++)
+		pool.start(new RunWorker(this));
+	pool.waitForDone();
+}
+
+bool RunValidator::matches(int run) const
+{
+	const RunClaim &claim = runClaims[run];
+	const RunResult &result = runResults[run];
+	return result.error.isEmpty() && result.finished && result.won == claim.won && qAbs(result.time - claim.time) <= tolerance;
+}
+
+const QVector<RunClaim>& RunValidator::claims() const
+{
+	return runClaims;
+}
+
+const QVector<RunResult>& RunValidator::results() const
+{
+	return runResults;
+}
+
+int RunValidator::run(const QStringList & arguments)
+{
+	QCommandLineParser parser;
+	parser.addPositionalArgument("directory", "Directory of <name>.claim and <name>.input files.");
+	parser.addOption(QCommandLineOption("validate"));
+	parser.addOption(QCommandLineOption("threads", "Worker threads.", "count", QString::number(QThread::idealThreadCount())));
+	parser.addOption(QCommandLineOption("tolerance", "Milliseconds the claimed time may be off.", "ms", "50"));
+	parser.addOption(QCommandLineOption("tail", "Milliseconds simulated after the last input.", "ms", "60000"));
+	parser.addOption(QCommandLineOption("cursor", "Cursor shape: rect, arrow or a list of x,y points.", "shape", "arrow"));
+	parser.addOption(QCommandLineOption("quiet", "Only print the summary and the runs that do not match."));
+
+	if (!parser.parse(arguments) || parser.positionalArguments().count() != 1)
+	{
+		std::cerr << "usage: MouseAssault --validate <directory> [--threads N] [--tolerance ms] [--tail ms] [--cursor shape] [--quiet]" << std::endl;
+		return 1;
+	}
+
+	RunValidator validator;
+	validator.setThreadCount(parser.value("threads").toInt());
+	validator.setTolerance(parser.value("tolerance").toDouble());
+	validator.setTail(parser.value("tail").toInt());
+	CursorShape shape;
+	if (!CursorShape::fromString(parser.value("cursor"), shape))
+	{
+		std::cerr << "bad cursor shape: " << parser.value("cursor").toStdString() << std::endl;
+		return 1;
+	}
+	validator.setCursorShape(shape);
+
+	if (!validator.load(parser.positionalArguments()[0]))
+	{
+		std::cerr << "no runs in " << parser.positionalArguments()[0].toStdString() << std::endl;
+		return 1;
+	}
+
+	QElapsedTimer timer;
+	timer.start();
+	validator.validate();
+	double seconds = timer.nsecsElapsed() / 1e9;
+
+	const QVector<RunClaim> &claims = validator.claims();
+	const QVector<RunResult> &results = validator.results();
+	int valid = 0;
+	int errors = 0;
+	qint64 simulated = 0;
+	std::cout << std::fixed << std::setprecision(3);
+	for (int i = 0; i < claims.count(); i++)
+	{
+		bool match = validator.matches(i);
+		valid += match;
+		errors += !results[i].error.isEmpty();
+		simulated += results[i].nsecs;
+		if (match && parser.isSet("quiet"))
+			continue;
+
+		std::cout << claims[i].name.toStdString() << ": ";
+		if (!results[i].error.isEmpty())
+		{
+			std::cout << "error, " << results[i].error.toStdString() << std::endl;
+			continue;
+		}
+		std::cout << (match ? "valid" : "invalid")
+			<< ", claimed " << (claims[i].won ? "won" : "lost") << " at " << claims[i].time << " ms"
+			<< ", simulated ";
+		if (results[i].finished)
+			std::cout << (results[i].won ? "won" : "lost") << " at " << results[i].time << " ms";
+		else
+			std::cout << "unfinished";
+		std::cout << ", " << results[i].nsecs / 1e6 << " ms" << std::endl;
+	}
+
+	int threads = validator.pool.maxThreadCount();
+	std::cout << claims.count() << " runs, " << valid << " valid, " << claims.count() - valid - errors << " invalid, " << errors << " errors" << std::endl;
+	std::cout << "simulation " << simulated / 1e6 / qMax(1, claims.count()) << " ms per run, "
+		<< claims.count() / seconds << " runs/s on " << threads << " threads, "
+		<< claims.count() / seconds / threads << " runs/s per thread" << std::endl;
+	return valid == claims.count() ? 0 : 2;
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QHash>
+#include <QThreadPool>
+#include <QAtomicInt>
+#include "gameenvironment.h"
+
+namespace GameEnvironment
+{
+	//A recorded run and the outcome its player claims, read from <name>.claim and <name>.input
+	struct RunClaim
+	{
+		QString name;
+		QString level;//built-in level name or json file relative to the run directory
+		bool won;
+		int time;//ms from the start to GameWon or GameOver
+		InputRecording recording;
+	};
+
+	struct RunResult
+	{
+		bool finished = false;
+		bool won = false;
+		double time = 0;//tick time GameWon or GameOver was emitted at
+		qint64 nsecs = 0;//wall time of the simulation
+		QString error;
+	};
+
+	//Re-simulates recorded runs headlessly on a pool of threads, ticking every Game exactly at the ticks the live
+	//game recorded. Recordings without ticks are ticked the way Game::run would schedule them: at every input
+	//event and at every time the state changes without input
+	class RunValidator
+	{
+	public:
+		RunValidator();
+		~RunValidator();
+		void setThreadCount(int count);
+		void setCursorShape(const CursorShape &shape);//has to match the shape the input was recorded with
+		void setTail(int ms);
+		void setTolerance(double ms);
+		bool load(const QString &directory);//false if no run was found
+		void validate();
+		bool matches(int run) const;
+		const QVector<RunClaim> &claims() const;
+		const QVector<RunResult> &results() const;
+
+		static int run(const QStringList &arguments);//--validate command line mode
+
+	private:
+		class RunWorker;
+
+		QThreadPool pool;
+		CursorShape cursor = CursorShape::arrow();
+		int tail = 60000;//ms simulated after the last input event before a run counts as unfinished
+		double tolerance = 50;//ms the claimed time may differ, the live game ticks late by its wake up jitter
+		QHash<QString, GameSettings> levels;//loaded once, every worker builds its own Game per level
+		QVector<RunClaim> runClaims;
+		QVector<RunResult> runResults;
+		QAtomicInt nextRun;
+	};
+}
@@ -0,0 +1,77 @@
+#include "scheduling.h"
+#include <iostream>
+#ifdef Q_OS_WIN
+#define NOMINMAX
+#include <windows.h>
+#endif
+#ifdef Q_OS_LINUX
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+using namespace GameEnvironment;
+
+bool SchedulingOptions::apply() const
+{
+	bool applied = true;
+
+	if (priority != QThread::InheritPriority && !realtime)
+		QThread::currentThread()->setPriority(priority);
+
+	if (realtime)
+	{
+#ifdef Q_OS_LINUX
+		sched_param parameters;
+		parameters.sched_priority = sched_get_priority_min(SCHED_FIFO) + 1;
+		if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &parameters) != 0)
+		{
+			std::cerr << "cannot switch to SCHED_FIFO, it needs CAP_SYS_NICE" << std::endl;
+			applied = false;
+		}
+#else
+		QThread::currentThread()->setPriority(QThread::TimeCriticalPriority);
+#endif
+	}
+
+	if (cpu >= 0)
+	{
+#ifdef Q_OS_WIN
+		if (cpu >= int(sizeof(DWORD_PTR) * 8) || SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << cpu) == 0)
+			applied = false;
+#elif defined(Q_OS_LINUX)
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(cpu, &set);
+		if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0)
+			applied = false;
+#else
+		applied = false;
+#endif
+		if (!applied)
+			std::cerr << "cannot pin the thread to cpu " << cpu << std::endl;
+	}
+	return applied;
+}
+
+SchedulingOptions SchedulingOptions::fromArguments(const QStringList & arguments)
+{
+	static const char *priorities[] = { "idle", "lowest", "low", "normal", "high", "highest", "timecritical" };
+
+	SchedulingOptions options;
+	int priority = arguments.indexOf("--priority");
+	if (priority >= 0 && priority + 1 < arguments.count())
+	{
+		for (int i = 0; i < 7; i++)
+		{
+			if (arguments[priority + 1] == priorities[i])
+				options.priority = QThread::Priority(QThread::IdlePriority + i);
+		}
+	}
+
+	int cpu = arguments.indexOf("--cpu");
+	if (cpu >= 0 && cpu + 1 < arguments.count())
+		options.cpu = arguments[cpu + 1].toInt();
+
+	options.realtime = arguments.contains("--realtime");
+	return options;
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include <QThread>
+#include <QStringList>
+
+namespace GameEnvironment
+{
+	//How the simulation thread is scheduled, applied by the thread to itself
+	struct SchedulingOptions
+	{
+		QThread::Priority priority = QThread::InheritPriority;
+		int cpu = -1;//pinned to this cpu when not negative
+		bool realtime = false;//SCHED_FIFO on Linux, time critical priority elsewhere
+
+		bool apply() const;//false if some option could not be applied, the rest still is
+		static SchedulingOptions fromArguments(const QStringList &arguments);//--priority <idle..timecritical> --cpu <n> --realtime
+	};
+}
@@ -0,0 +1,163 @@
+#include "snapshothistory.h"
+#include "gameenvironment.h"
+
+using namespace GameEnvironment;
+
+SnapshotHistory::SnapshotHistory(int groupCount, int groupSize)
+	: groups(qMax(groupCount, 2)), groupSize(qMax(groupSize, 1))
+{
+}
+
+void SnapshotHistory::clear()
+{
+	firstGroup = 0;
+	usedGroups = 0;
+}
+
+void SnapshotHistory::push(double time, const SimulationState & state, const QVector<Ring> & rings)
+{
+	flatten(state, rings, scratch);
+
+	if (usedGroups == 0 || group(usedGroups - 1).snapshots.count() == groupSize)
+	{
+		if (usedGroups == groups.count())
+		{
+			firstGroup = (firstGroup + 1) % groups.count();
+			usedGroups--;
+		}
+		usedGroups++;
+
+		Group &keyGroup = group(usedGroups - 1);
+		keyGroup.keyframe = scratch;
+		keyGroup.snapshots.resize(1);
+		keyGroup.snapshots[0].time = time;
+		keyGroup.snapshots[0].changed.clear();
+		keyGroup.snapshots[0].values.clear();
+		return;
+	}
+
+	Group &last = group(usedGroups - 1);
+	last.snapshots.resize(last.snapshots.count() + 1);
+	Snapshot &snapshot = last.snapshots.last();
+	snapshot.time = time;
+	snapshot.changed.clear();
+	snapshot.values.clear();
+	for (int i = 0; i < scratch.count(); i++)
+	{
+		if (scratch[i] != last.keyframe[i])
+		{
+			snapshot.changed.append(i);
+			snapshot.values.append(scratch[i]);
+		}
+	}
+}
+
+void SnapshotHistory::restore(int index, SimulationState & state, QVector<Ring> & rings)
+{
+	Group &keyGroup = group(index / groupSize);
+	const Snapshot &snapshot = keyGroup.snapshots[index % groupSize];
+
+	scratch = keyGroup.keyframe;
+	for (int i = 0; i < snapshot.changed.count(); i++)
+		scratch[snapshot.changed[i]] = snapshot.values[i];
+	unflatten(scratch, state, rings);
+
+	usedGroups = index / groupSize + 1;
+	keyGroup.snapshots.resize(index % groupSize + 1);
+}
+
+int SnapshotHistory::indexAt(double time) const
+{
+	int low = 0;
+	int high = count() - 1;
+	while (low < high)
+	{
+		int middle = (low + high + 1) / 2;
+		if (timeAt(middle) <= time)
+			low = middle;
+		else
+			high = middle - 1;
+	}
+	return low;
+}
+
+double SnapshotHistory::timeAt(int index) const
+{
+	return group(index / groupSize).snapshots[index % groupSize].time;
+}
+
+int SnapshotHistory::count() const
+{
+	return usedGroups == 0 ? 0 : (usedGroups - 1) * groupSize + group(usedGroups - 1).snapshots.count();
+}
+
+int SnapshotHistory::memoryUsage() const
+{
+	int bytes = 0;
+	for (int i = 0; i < usedGroups; i++)
+	{
+		const Group &used = group(i);
+		bytes += used.keyframe.count() * sizeof(double);
+		for (int j = 0; j < used.snapshots.count(); j++)
+			bytes += sizeof(Snapshot) + used.snapshots[j].changed.count() * (sizeof(quint32) + sizeof(double));
+	}
+	return bytes;
+}
+
+SnapshotHistory::Group & SnapshotHistory::group(int index)
+{
+	return groups[(firstGroup + index) % groups.count()];
+}
+
+const SnapshotHistory::Group & SnapshotHistory::group(int index) const
+{
+	return groups[(firstGroup + index) % groups.count()];
+}
+
+void SnapshotHistory::flatten(const SimulationState & state, const QVector<Ring> & rings, QVector<double> & values)
+{
+	values.resize(0);
+	values << state.currentCoreWidthScore
+		<< state.currentEnergyVolume << state.energyStartTime << state.lastEnergyVolume
+		<< state.currentFreezeVolume << state.freezeStartTime << state.lastFreezeVolume
+		<< state.gameFinishedTime << state.gameFinished << state.gameWon << state.finishEmitted
+		<< state.rotating << state.frozen;
+
+	for (int i = 0; i < rings.count(); i++)
+	{
+		const Ring &ring = rings[i];
+		values << ring.rotation << ring.additionalRotation
+			<< ring.selectionStartTime << ring.selectedScore << ring.lastSelectionScore
+			<< ring.isSelected << ring.isRotating;
+	}
+}
+
+void SnapshotHistory::unflatten(const QVector<double> & values, SimulationState & state, QVector<Ring> & rings)
+{
+	int i = 0;
+	state.currentCoreWidthScore = values[i++];
+	state.currentEnergyVolume = values[i++];
+	state.energyStartTime = values[i++];
+	state.lastEnergyVolume = values[i++];
+	state.currentFreezeVolume = values[i++];
+	state.freezeStartTime = values[i++];
+	state.lastFreezeVolume = values[i++];
+	state.gameFinishedTime = values[i++];
+	state.gameFinished = values[i++] != 0;
+	state.gameWon = values[i++] != 0;
+	state.finishEmitted = values[i++] != 0;
+	state.rotating = values[i++] != 0;
+	state.frozen = values[i++] != 0;
+
+	for (int j = 0; j < rings.count(); j++)
+	{
+		Ring &ring = rings[j];
+		ring.rotation = values[i++];
+		ring.additionalRotation = values[i++];
+		ring.selectionStartTime = values[i++];
+		ring.selectedScore = values[i++];
+		ring.lastSelectionScore = values[i++];
+		ring.isSelected = values[i++] != 0;
+		ring.isRotating = values[i++] != 0;
+	}
+}
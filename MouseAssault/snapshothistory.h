@@ -0,0 +1,50 @@
+#pragma once
+#include <QVector>
+
+namespace GameEnvironment
+{
+	struct Ring;
+	struct SimulationState;
+
+	//Bounded history of simulation snapshots used for rewinding.
+	//Snapshots are kept in groups: the first one of a group is stored whole as a keyframe,
+	//the others only keep the values that differ from it, so any snapshot is rebuilt from two entries.
+	//When the history is full the oldest group is dropped.
+	class SnapshotHistory
+	{
+	public:
+		SnapshotHistory(int groupCount = 6, int groupSize = 20);
+		void clear();
+		void push(double time, const SimulationState &state, const QVector<Ring> &rings);
+		void restore(int index, SimulationState &state, QVector<Ring> &rings);//drops every newer snapshot
+		int indexAt(double time) const;//latest snapshot not after time, the oldest one if there is none
+		double timeAt(int index) const;//index 0 is the oldest snapshot
+		int count() const;
+		int memoryUsage() const;//in bytes
+
+	private:
+		struct Snapshot
+		{
+			double time;
+			QVector<quint32> changed;//indices into the keyframe, levels with thousands of rings flatten to more than 65536 values
+			QVector<double> values;
+		};
+
+		struct Group
+		{
+			QVector<double> keyframe;
+			QVector<Snapshot> snapshots;//snapshots[0] is the keyframe itself
+		};
+
+		Group &group(int index);
+		const Group &group(int index) const;
+		static void flatten(const SimulationState &state, const QVector<Ring> &rings, QVector<double> &values);
+		static void unflatten(const QVector<double> &values, SimulationState &state, QVector<Ring> &rings);
+
+		QVector<Group> groups;//circular
+		int groupSize;
+		int firstGroup = 0;
+		int usedGroups = 0;
+		QVector<double> scratch;
+	};
+}
@@ -0,0 +1,139 @@
+#include "statepublisher.h"
+#include "gameenvironment.h"
+#include "collision.h"
+#include <QThread>
+#include <cstring>
+#include <atomic>
+#include <iostream>
+
+using namespace GameEnvironment;
+
+namespace
+{
+	static_assert(sizeof(std::atomic<quint32>) == sizeof(quint32) && ATOMIC_INT_LOCK_FREE == 2, "the shared sequence needs lock free 32 bit atomics");
+
+	std::atomic<quint32> &sequenceOf(const SharedGameState &shared)
+	{
+		return *reinterpret_cast<std::atomic<quint32>*>(const_cast<quint32*>(&shared.sequence));
+	}
+}
+
+StatePublisher::StatePublisher(const QString & key) : memory(key)
+{
+}
+
+bool StatePublisher::open()
+{
+	if (!memory.create(sizeof(SharedGameState)))
+	{
+		//a segment left by a crashed game on Unix is destroyed by the last detach, one that is still in use is not
+		if (memory.error() == QSharedMemory::AlreadyExists && memory.attach())
+			memory.detach();
+		if (!memory.create(sizeof(SharedGameState)))
+		{
+			std::cerr << "cannot share game state: " << memory.errorString().toStdString() << std::endl;
+			return false;
+		}
+	}
+
+	//only a segment created here is initialized, the magic goes in last so early readers reject it
+	shared = static_cast<SharedGameState*>(memory.data());
+	memset(shared, 0, sizeof(SharedGameState));
+	shared->version = SharedGameState::layoutVersion;
+	std::atomic_thread_fence(std::memory_order_release);
+	shared->magic = SharedGameState::magicValue;
+	std::cout << "sharing game state under " << memory.nativeKey().toStdString() << std::endl;
+	return true;
+}
+
+void StatePublisher::publish(double time, const SimulationState & state, const QVector<Ring> & rings, const QRectF & cursor)
+{
+	if (!shared)
+		return;
+
+	std::atomic<quint32> &sequence = sequenceOf(*shared);
+	quint32 current = sequence.load(std::memory_order_relaxed);
+	sequence.store(current + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	shared->tick = ticks++;
+	shared->time = time;
+	shared->cursor[0] = cursor.x();
+	shared->cursor[1] = cursor.y();
+	shared->cursor[2] = cursor.width();
+	shared->cursor[3] = cursor.height();
+	shared->energyVolume = state.currentEnergyVolume;
+	shared->freezeVolume = state.currentFreezeVolume;
+	shared->coreWidthScore = state.currentCoreWidthScore;
+	shared->outcome = state.gameFinished ? (state.gameWon ? Collision::Won : Collision::Lost) : Collision::None;
+
+	shared->ringCount = rings.count();
+	shared->publishedRings = qMin(rings.count(), int(SharedGameState::maxRings));
+	shared->flags = shared->publishedRings < shared->ringCount ? SharedGameState::truncatedRings : 0;
+	for (quint32 i = 0; i < shared->publishedRings; i++)
+	{
+		shared->rotation[i] = Circle::adjustAngle(rings[i].rotation + rings[i].additionalRotation);
+		shared->selectedScore[i] = rings[i].selectedScore;
+	}
+
+	sequence.store(current + 2, std::memory_order_release);
+}
+
+bool StatePublisher::read(const SharedGameState & shared, SharedGameState & copy)
+{
+	for (int attempt = 0; attempt < 1000; attempt++)
+	{
+		quint32 before = sequenceOf(shared).load(std::memory_order_acquire);
+		if (before & 1)
+			continue;
+
+		memcpy(&copy, &shared, sizeof(SharedGameState));
+		std::atomic_thread_fence(std::memory_order_acquire);
+
+		if (sequenceOf(shared).load(std::memory_order_relaxed) == before)
+			return true;
+	}
+	return false;
+}
+
+int StatePublisher::observe(const QStringList & arguments)
+{
+	int observe = arguments.indexOf("--observe");
+	if (observe < 0 || observe + 1 >= arguments.count())
+	{
+		std::cerr << "usage: MouseAssault --observe <key>" << std::endl;
+		return 1;
+	}
+
+	QSharedMemory memory(arguments[observe + 1]);
+	if (!memory.attach(QSharedMemory::ReadOnly))
+	{
+		std::cerr << "cannot attach: " << memory.errorString().toStdString() << std::endl;
+		return 1;
+	}
+
+	const SharedGameState &shared = *static_cast<const SharedGameState*>(memory.constData());
+	if (shared.magic != SharedGameState::magicValue || shared.version != SharedGameState::layoutVersion)
+	{
+		std::cerr << "unknown shared state layout" << std::endl;
+		return 1;
+	}
+
+	SharedGameState copy;
+	qint64 lastTick = -1;
+	forever
+	{
+		if (read(shared, copy) && copy.tick != lastTick)
+		{
+			std::cout << copy.tick << ' ' << copy.time << " energy " << copy.energyVolume << " freeze " << copy.freezeVolume
+				<< " core " << copy.coreWidthScore << " outcome " << copy.outcome << " rings";
+			for (quint32 i = 0; i < copy.publishedRings; i++)
+				std::cout << ' ' << copy.rotation[i];
+			if (copy.flags & SharedGameState::truncatedRings)
+				std::cout << " ... " << copy.ringCount << " in total";
+			std::cout << std::endl;
+			lastTick = copy.tick;
+		}
+		QThread::msleep(100);
+	}
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <QSharedMemory>
+#include <QStringList>
+#include <QVector>
+#include <QRectF>
+
+namespace GameEnvironment
+{
+	struct Ring;
+	struct SimulationState;
+
+	//Layout of the shared segment. Readers without Qt map it by QSharedMemory::nativeKey(), which open() prints:
+	//on Windows it names the file mapping, on Unix it is a file path and ftok(path, 'Q') gives the System V key.
+	//sequence is odd while the simulation writes, a reader copies the fields and retries if it changed meanwhile.
+	//It is a plain quint32 so the struct stays plain data, both sides access it with atomic operations
+	struct SharedGameState
+	{
+		static const quint32 magicValue = 0x4d415353;//"MASS"
+		static const quint32 layoutVersion = 2;
+		static const int maxRings = 32;
+		static const quint32 truncatedRings = 1;//flags bit, the level has more rings than the segment holds
+
+		quint32 magic;
+		quint32 version;
+		quint32 sequence;
+		quint32 ringCount;//rings of the level, may be more than maxRings
+		qint64 tick;
+
+		double time;//ms since the round started
+		double cursor[4];//x, y, width, height in level coordinates
+		double energyVolume;
+		double freezeVolume;
+		double coreWidthScore;
+		qint32 outcome;//Collision::Outcome
+		quint32 publishedRings;//entries of rotation and selectedScore that are filled, the innermost rings first
+		quint32 flags;
+		quint32 padding;
+
+		double rotation[maxRings];//radians, rotation + additionalRotation
+		double selectedScore[maxRings];
+	};
+
+	//Publishes every tick to a shared memory segment without locks, the simulation never waits for readers
+	class StatePublisher
+	{
+	public:
+		StatePublisher(const QString &key);
+		bool open();//creates the segment, false on error or if another process still has it attached
+		void publish(double time, const SimulationState &state, const QVector<Ring> &rings, const QRectF &cursor);
+
+		static bool read(const SharedGameState &shared, SharedGameState &copy);//false if the writer kept it busy
+		static int observe(const QStringList &arguments);//--observe command line mode
+
+	private:
+		QSharedMemory memory;
+		SharedGameState *shared = nullptr;
+		qint64 ticks = 0;
+	};
+}
@@ -0,0 +1,211 @@
+#pragma once
+#include <array>
+#include "collision.h"
+#include "ringintegrator.h"
+
+namespace GameEnvironment
+{
+	template<int MaxArcCount>
+	struct StaticRing
+	{
+		int width;
+		double angleSpeed;
+		double additionalRotation;
+		int arcCount;
+		Arc arcs[MaxArcCount];
+	};
+
+	//Built-in level as a constexpr table, ring and arc counts are template arguments
+	template<int RingCount, int MaxArcCount>
+	struct StaticLevel
+	{
+		StaticRing<MaxArcCount> rings[RingCount];//rings[0] is the core, only its width is used
+
+		constexpr int internalRadius(int i) const { return i == 0 ? 0 : internalRadius(i - 1) + rings[i - 1].width; }
+		constexpr int totalRadius() const { return internalRadius(RingCount); }
+
+		QVector<Ring> toRings() const;
+	};
+
+	template<int RingCount, int MaxArcCount>
+	QVector<Ring> StaticLevel<RingCount, MaxArcCount>::toRings() const
+	{
+		QVector<Ring> result;
+		for (int i = 0; i < RingCount; i++)
+		{
+			Ring ring(rings[i].width, rings[i].angleSpeed, 0, rings[i].additionalRotation);
+			for (int j = 0; j < rings[i].arcCount; j++)
+				ring.arcs.append(rings[i].arcs[j]);
+			ring.internalRadius = internalRadius(i);
+			result.append(ring);
+		}
+		return result;
+	}
+
+	template<int Capacity>
+	class FixedPoints
+	{
+	public:
+		void clear() { size = 0; }
+		void append(const QPointF &point) { points[size++] = point; }
+		int count() const { return size; }
+		const QPointF &operator[](int i) const { return points[i]; }
+	private:
+		std::array<QPointF, Capacity> points;
+		int size = 0;
+	};
+
+	//RingIntegrator's update for a StaticLevel. The per-ring loops have compile-time bounds, radii and arc ends
+	//are precomputed into fixed arrays and the rect cursor fills a fixed point buffer, so nothing is allocated
+	//and the compiler can unroll the rings. Gives exactly the results of the dynamic loop
+	template<int RingCount, int MaxArcCount>
+	class StaticLevelIntegration : public StaticRingIntegration
+	{
+	public:
+		StaticLevelIntegration(const StaticLevel<RingCount, MaxArcCount> &level);
+		int ringCount() const { return RingCount; }
+		int integrate(const QVector<Ring> &source, QVector<Ring> &target, const RingStep &step, double &horizon);
+
+	private:
+		Collision::Outcome integrateRing(Ring &ring, int index, bool finished, const RingStep &step, double &horizon);
+
+		std::array<int, RingCount> arcCount;
+		std::array<double, RingCount> sqrInternalRadius;
+		std::array<double, RingCount> sqrExternalRadius;
+		std::array<int, RingCount> internalRadius;
+		std::array<int, RingCount> externalRadius;
+		std::array<std::array<double, MaxArcCount>, RingCount> arcStartOffset;
+		std::array<std::array<double, MaxArcCount>, RingCount> arcEndOffset;
+		FixedPoints<20> rectPoints;//4 corners and 2 crossings for each of 4 edges with 2 radii
+		QVector<QPointF> polygonPoints;//a polygon cursor has no fixed bound, reused between ticks
+		QVector<double> angles;
+	};
+
+	template<int RingCount, int MaxArcCount>
+	StaticLevelIntegration<RingCount, MaxArcCount>::StaticLevelIntegration(const StaticLevel<RingCount, MaxArcCount> &level)
+	{
+		for (int i = 0; i < RingCount; i++)
+		{
+			arcCount[i] = level.rings[i].arcCount;
+			internalRadius[i] = level.internalRadius(i);
+			externalRadius[i] = level.internalRadius(i) + level.rings[i].width;
+			sqrInternalRadius[i] = pow(internalRadius[i], 2.0);
+			sqrExternalRadius[i] = pow(externalRadius[i], 2.0);
+			for (int j = 0; j < MaxArcCount; j++)
+			{
+				const Arc &arc = level.rings[i].arcs[j];
+				arcStartOffset[i][j] = arc.position * 2.0 * M_PI;
+				arcEndOffset[i][j] = (arc.position + arc.length) * 2.0 * M_PI;
+			}
+		}
+	}
+
+	template<int RingCount, int MaxArcCount>
+	int StaticLevelIntegration<RingCount, MaxArcCount>::integrate(const QVector<Ring> &source, QVector<Ring> &target, const RingStep &step, double &horizon)
+	{
+		target.resize(RingCount);
+		const Ring *sourceRings = source.constData();
+		Ring *targetRings = target.data();
+
+		int finisher = -1;
+		bool finished = step.finished;
+		double ringsHorizon = INFINITY;
+		for (int i = 0; i < RingCount; i++)
+		{
+			targetRings[i] = sourceRings[i];
+			if (integrateRing(targetRings[i], i, finished, step, ringsHorizon) != Collision::None && finisher < 0)
+			{
+				finisher = i;
+				finished = true;
+			}
+		}
+		horizon = qMin(horizon, ringsHorizon);
+		return finisher;
+	}
+
+	template<int RingCount, int MaxArcCount>
+	Collision::Outcome StaticLevelIntegration<RingCount, MaxArcCount>::integrateRing(Ring &ring, int index, bool finished, const RingStep &step, double &horizon)
+	{
+		double fullRotation = 0;
+		if (index != 0)
+		{
+			if (ring.isRotating || (step.frozen && !finished))
+			{
+				ring.additionalRotation += ring.rotation - ring.angleSpeed * step.deltaTime / double(1000);
+				ring.additionalRotation = Circle::adjustAngle(ring.additionalRotation);
+			}
+			ring.rotation = Circle::adjustAngle(ring.angleSpeed * step.deltaTime / double(1000));
+			fullRotation = ring.additionalRotation + ring.rotation;
+
+			if (ring.isRotating && !step.rotating)
+				ring.isRotating = false;
+		}
+
+		bool touches = step.polygon ? Collision::touchesRing(*step.polygon, sqrInternalRadius[index], sqrExternalRadius[index])
+			: Collision::touchesRing(step.mouseRect, sqrInternalRadius[index], sqrExternalRadius[index]);
+		if (!touches || finished)
+		{
+			ring.isRotating = false;
+			if (ring.isSelected)
+			{
+				ring.isSelected = false;
+				ring.lastSelectionScore = ring.selectedScore;
+				ring.selectionStartTime = step.deltaTime;
+			}
+			if (ring.selectedScore > 0)
+				ring.selectedScore = qMax(ring.lastSelectionScore - step.selectingSpeed * (step.deltaTime - ring.selectionStartTime) / double(1000), 0.0);
+			return Collision::None;
+		}
+
+		if (index == 0)
+			return Collision::Won;
+
+		Collision::Outcome outcome = Collision::None;
+		if (step.polygon)
+		{
+			polygonPoints.clear();
+			Collision::intersectionPoints(*step.polygon, sqrInternalRadius[index], sqrExternalRadius[index], polygonPoints);
+			Collision::pointAngles(polygonPoints, angles);
+			for (int j = 0; j < MaxArcCount && j < arcCount[index]; j++)
+			{
+				if (Collision::sectorHit(*step.polygon, angles, fullRotation, arcStartOffset[index][j], arcEndOffset[index][j], internalRadius[index], externalRadius[index]))
+					outcome = Collision::Lost;
+			}
+		}
+		else
+		{
+			rectPoints.clear();
+			Collision::intersectionPoints(step.mouseRect, sqrInternalRadius[index], sqrExternalRadius[index], rectPoints);
+			for (int j = 0; j < MaxArcCount && j < arcCount[index]; j++)
+			{
+				if (Collision::arcHit(rectPoints, fullRotation, arcStartOffset[index][j], arcEndOffset[index][j]))
+					outcome = Collision::Lost;
+			}
+		}
+
+		//a still cursor can only be hit by an arc turning into it
+		if (outcome == Collision::None && !ring.isRotating && !step.frozen)
+		{
+			if (!step.polygon)
+				Collision::pointAngles(rectPoints, angles);
+			for (int j = 0; j < MaxArcCount && j < arcCount[index]; j++)
+				horizon = qMin(horizon, Collision::contactTime(angles, fullRotation, arcStartOffset[index][j], arcEndOffset[index][j], ring.angleSpeed) * 1000);
+		}
+
+		if (step.rotating)
+		{
+			ring.isRotating = true;
+			ring.additionalRotation = Circle::adjustAngle(ring.additionalRotation + step.mouseAngleDifference);
+		}
+
+		if (!ring.isSelected)
+		{
+			ring.isSelected = true;
+			ring.lastSelectionScore = ring.selectedScore;
+			ring.selectionStartTime = step.deltaTime;
+		}
+		if (ring.selectedScore < 1)
+			ring.selectedScore = qMin(ring.lastSelectionScore + step.selectingSpeed * (step.deltaTime - ring.selectionStartTime) / double(1000), 1.0);
+		return outcome;
+	}
+}
\ No newline at end of file